@@ -0,0 +1,93 @@
+#include <print>
+#include <algorithm>
+#include "Vgpu.h"
+#include "Vgpu_age_arbitration.h"
+#include "Vgpu_fair_share_arbitration.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Memory arbitration benchmark
+// Runs a memory bound kernel under the different data memory controller arbitration policies and reports
+// how long the consumers of each core waited for a channel
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t NUM_CORES = 2;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 1'000'000;
+constexpr IData OUTPUT_ADDRESS = 1536;
+
+template <typename T, std::size_t N>
+constexpr auto array_size(const VlUnpacked<T, N>&) -> std::size_t {
+    return N;
+}
+
+struct BenchmarkResult {
+    uint32_t cycles;
+    std::array<uint64_t, NUM_CORES> core_wait_cycles;
+    IData max_consumer_wait_cycles;
+
+    auto columns() const {
+        return std::tuple{cycles, core_wait_cycles[0], core_wait_cycles[1], max_consumer_wait_cycles};
+    }
+};
+
+// out[i] = in[4 * i], the stride defeats coalescing so every lane needs its own memory request
+template <typename Gpu>
+auto run_kernel(uint32_t num_blocks, uint32_t num_warps_per_block) -> std::optional<BenchmarkResult> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < 4 * num_threads; i++) {
+        data_mem.push_data(i);
+    }
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(slli(5_x, 9_x, 2));
+    instruction_mem.push_instruction(lw(6_x, 5_x, 0));
+    instruction_mem.push_instruction(sw(9_x, 6_x, OUTPUT_ADDRESS));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        if (data_mem[OUTPUT_ADDRESS + i] != 4 * i) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], 4 * i);
+            return std::nullopt;
+        }
+    }
+
+    auto result = BenchmarkResult{ .cycles = *cycles, .core_wait_cycles = {}, .max_consumer_wait_cycles = 0 };
+    const auto num_consumers = array_size(top.perf_data_mem_wait_cycles);
+    const auto consumers_per_core = num_consumers / NUM_CORES;
+    for (auto i = 0u; i < num_consumers; i++) {
+        const IData wait_cycles = top.perf_data_mem_wait_cycles[i];
+        result.core_wait_cycles[i / consumers_per_core] += wait_cycles;
+        result.max_consumer_wait_cycles = std::max(result.max_consumer_wait_cycles, wait_cycles);
+    }
+    return result;
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 8;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"policy", 12, {{"cycles", 10}, {"core 0 wait", 12}, {"core 1 wait", 12}, {"max single wait", 16}}};
+
+    std::println("Strided copy, {} blocks of {} warps", num_blocks, num_warps_per_block);
+    table.print_header();
+    table.print_result("round-robin", run_kernel<Vgpu>(num_blocks, num_warps_per_block));
+    table.print_result("age-based", run_kernel<Vgpu_age_arbitration>(num_blocks, num_warps_per_block));
+    table.print_result("fair share", run_kernel<Vgpu_fair_share_arbitration>(num_blocks, num_warps_per_block));
+
+    return 0;
+}
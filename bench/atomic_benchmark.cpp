@@ -0,0 +1,173 @@
+#include <print>
+#include <vector>
+#include <string>
+#include "Vgpu.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Atomic benchmark
+// Histogram of the inputs with atomic increments into few or many buckets, which serialise more often the fewer the buckets.
+// Sum of all inputs, once as a single kernel where every thread adds its value to the total atomically,
+// and once as a tree reduction with one kernel launch per level through global memory
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData INPUT_ADDRESS = 1024;
+constexpr IData OUTPUT_ADDRESS = 512;
+
+struct Result {
+    uint32_t cycles;
+    uint32_t launches;
+
+    auto columns() const {
+        return std::tuple{cycles, launches};
+    }
+};
+
+// Runs one kernel on a fresh GPU, the data memory is carried over between launches
+auto launch(const std::vector<sim::InstructionBits>& program, sim::data_memory_container_t& memory,
+            uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency, Result& result) -> bool {
+    auto top = Vgpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = latency;
+    data_mem.memory = memory;
+
+    for (const auto& instruction : program) {
+        instruction_mem.push_instruction(instruction);
+    }
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return false;
+    }
+
+    memory = data_mem.memory;
+    result.cycles += *cycles;
+    result.launches++;
+    return true;
+}
+
+auto input_value(uint32_t i) -> IData {
+    return (i * 7 + i / 5) % 251;
+}
+
+auto run_histogram(uint32_t num_buckets, uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency) -> std::optional<Result> {
+    const auto block_size = num_warps_per_block * THREADS_PER_WARP;
+    const auto num_threads = num_blocks * block_size;
+
+    auto memory = sim::data_memory_container_t{};
+    for (auto i = 0u; i < num_threads; i++) {
+        memory[INPUT_ADDRESS + i] = input_value(i);
+    }
+
+    auto result = Result{};
+
+    // The bucket of a value is given by its low bits, x8 = 1 is the increment
+    auto program = bench::global_thread_id(9_x, num_warps_per_block);
+    program.insert(program.end(), {
+        addi(8_x, 0_x, 1),
+        lw(5_x, 9_x, INPUT_ADDRESS),
+        andi(6_x, 5_x, num_buckets - 1),
+        addi(6_x, 6_x, OUTPUT_ADDRESS),
+        amoadd_w(0_x, 6_x, 8_x),
+        halt(),
+    });
+    if (!launch(program, memory, num_blocks, num_warps_per_block, latency, result)) {
+        return std::nullopt;
+    }
+
+    auto expected = std::vector<IData>(num_buckets, 0);
+    for (auto i = 0u; i < num_threads; i++) {
+        expected[input_value(i) % num_buckets]++;
+    }
+    for (auto bucket = 0u; bucket < num_buckets; bucket++) {
+        if (memory[OUTPUT_ADDRESS + bucket] != expected[bucket]) {
+            std::println(stderr, "Error: Bucket {} counted {} instead of {}", bucket, memory[OUTPUT_ADDRESS + bucket], expected[bucket]);
+            return std::nullopt;
+        }
+    }
+
+    return result;
+}
+
+auto run_sum(bool use_atomics, uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency) -> std::optional<Result> {
+    const auto block_size = num_warps_per_block * THREADS_PER_WARP;
+    const auto num_threads = num_blocks * block_size;
+
+    auto memory = sim::data_memory_container_t{};
+    for (auto i = 0u; i < num_threads; i++) {
+        memory[INPUT_ADDRESS + i] = input_value(i);
+    }
+
+    auto result = Result{};
+
+    auto program = bench::global_thread_id(9_x, num_warps_per_block);
+
+    if (use_atomics) {
+        program.push_back(lw(5_x, 9_x, INPUT_ADDRESS));
+        program.push_back(addi(6_x, 0_x, OUTPUT_ADDRESS));
+        program.push_back(amoadd_w(0_x, 6_x, 5_x));
+        program.push_back(halt());
+        if (!launch(program, memory, num_blocks, num_warps_per_block, latency, result)) {
+            return std::nullopt;
+        }
+    } else {
+        // Every level is a kernel of its own, the partial sums are kept in place in global memory
+        for (auto stride = num_threads / 2; stride > 0; stride /= 2) {
+            const auto level_blocks = std::max(1u, stride / block_size);
+            auto level = program;
+            level.push_back(slti(6_x, 9_x, stride));
+            level.push_back(sx_slt(1_s, 0_x, 6_x));
+            level.push_back(lw(5_x, 9_x, INPUT_ADDRESS));
+            level.push_back(lw(7_x, 9_x, INPUT_ADDRESS + stride));
+            level.push_back(add(5_x, 5_x, 7_x));
+            level.push_back(sw(9_x, 5_x, INPUT_ADDRESS));
+            level.push_back(halt());
+            if (!launch(level, memory, level_blocks, num_warps_per_block, latency, result)) {
+                return std::nullopt;
+            }
+        }
+        memory[OUTPUT_ADDRESS] = memory[INPUT_ADDRESS];
+    }
+
+    auto expected = IData{0};
+    for (auto i = 0u; i < num_threads; i++) {
+        expected += input_value(i);
+    }
+    if (memory[OUTPUT_ADDRESS] != expected) {
+        std::println(stderr, "Error: Summed up to {} instead of {}", memory[OUTPUT_ADDRESS], expected);
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 8;
+    constexpr uint32_t num_warps_per_block = 2;
+    constexpr uint32_t latency = 20;
+
+    const auto histogram_table = bench::Table{"buckets", 16, {{"cycles", 10}, {"launches", 8}}};
+    const auto sum_table = bench::Table{"sum", 16, {{"cycles", 10}, {"launches", 8}}};
+
+    std::println("Histogram of {} values, memory latency of {} cycles, {} blocks of {} warps", num_blocks * num_warps_per_block * THREADS_PER_WARP, latency, num_blocks, num_warps_per_block);
+    histogram_table.print_header();
+    for (auto num_buckets : {1u, 8u, 64u}) {
+        histogram_table.print_result(std::to_string(num_buckets), run_histogram(num_buckets, num_blocks, num_warps_per_block, latency));
+    }
+    std::println("");
+
+    std::println("Sum of {} values, memory latency of {} cycles, {} blocks of {} warps", num_blocks * num_warps_per_block * THREADS_PER_WARP, latency, num_blocks, num_warps_per_block);
+    sum_table.print_header();
+    sum_table.print_result("atomic add", run_sum(true, num_blocks, num_warps_per_block, latency));
+    sum_table.print_result("kernel launches", run_sum(false, num_blocks, num_warps_per_block, latency));
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <print>
+#include <vector>
+#include "Vgpu.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Barrier benchmark
+// Tree reduction of the values of a block, once as a single kernel whose warps meet at a barrier before every level
+// and exchange their partial sums through the scratchpad, and once as one kernel launch per level through global memory
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData INPUT_ADDRESS = 1024;
+constexpr IData OUTPUT_ADDRESS = 512;
+
+struct Result {
+    uint32_t cycles;
+    uint32_t launches;
+    uint32_t barrier_wait_cycles;
+
+    auto columns() const {
+        return std::tuple{cycles, launches, barrier_wait_cycles};
+    }
+};
+
+// Runs one kernel on a fresh GPU, the data memory is carried over between launches
+auto launch(const std::vector<sim::InstructionBits>& program, sim::data_memory_container_t& memory,
+            uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency, Result& result) -> bool {
+    auto top = Vgpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = latency;
+    data_mem.memory = memory;
+
+    for (const auto& instruction : program) {
+        instruction_mem.push_instruction(instruction);
+    }
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return false;
+    }
+
+    memory = data_mem.memory;
+    result.cycles += *cycles;
+    result.launches++;
+    result.barrier_wait_cycles += top.perf_barrier_wait_cycles;
+    return true;
+}
+
+auto run_reduction(bool use_barrier, uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency) -> std::optional<Result> {
+    const auto block_size = num_warps_per_block * THREADS_PER_WARP;
+    const auto num_threads = num_blocks * block_size;
+
+    auto memory = sim::data_memory_container_t{};
+    for (auto i = 0u; i < num_threads; i++) {
+        memory[INPUT_ADDRESS + i] = i % 7 + 1;
+    }
+
+    auto result = Result{};
+
+    auto program = bench::global_thread_id(9_x, num_warps_per_block);
+
+    if (use_barrier) {
+        program.push_back(lw(5_x, 9_x, INPUT_ADDRESS));
+        program.push_back(sws(1_x, 5_x, 0));
+        for (auto stride = block_size / 2; stride > 0; stride /= 2) {
+            // Only the lanes below the stride add the partial sum of the lane stride words further on
+            program.push_back(bar());
+            program.push_back(sx_slti(1_s, 1_x, stride));
+            program.push_back(lws(6_x, 1_x, stride));
+            program.push_back(add(5_x, 5_x, 6_x));
+            program.push_back(sws(1_x, 5_x, 0));
+        }
+        program.push_back(sw(2_x, 5_x, OUTPUT_ADDRESS));
+        program.push_back(halt());
+        if (!launch(program, memory, num_blocks, num_warps_per_block, latency, result)) {
+            return std::nullopt;
+        }
+    } else {
+        // Without a barrier every level is a kernel of its own, the partial sums are kept in place in global memory
+        for (auto stride = block_size / 2; stride > 0; stride /= 2) {
+            auto level = program;
+            level.push_back(sx_slti(1_s, 1_x, stride));
+            level.push_back(lw(5_x, 9_x, INPUT_ADDRESS));
+            level.push_back(lw(6_x, 9_x, INPUT_ADDRESS + stride));
+            level.push_back(add(5_x, 5_x, 6_x));
+            level.push_back(sw(9_x, 5_x, INPUT_ADDRESS));
+            level.push_back(halt());
+            if (!launch(level, memory, num_blocks, num_warps_per_block, latency, result)) {
+                return std::nullopt;
+            }
+        }
+        for (auto block = 0u; block < num_blocks; block++) {
+            memory[OUTPUT_ADDRESS + block] = memory[INPUT_ADDRESS + block * block_size];
+        }
+    }
+
+    for (auto block = 0u; block < num_blocks; block++) {
+        auto expected = 0u;
+        for (auto i = block * block_size; i < (block + 1) * block_size; i++) {
+            expected += i % 7 + 1;
+        }
+        if (memory[OUTPUT_ADDRESS + block] != expected) {
+            std::println(stderr, "Error: Block {} summed up to {} instead of {}", block, memory[OUTPUT_ADDRESS + block], expected);
+            return std::nullopt;
+        }
+    }
+
+    return result;
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 8;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"levels", 16, {{"cycles", 10}, {"launches", 8}, {"barrier wait", 12}}};
+
+    for (auto latency : {0u, 20u}) {
+        std::println("Sum of {} values per block, memory latency of {} cycles, {} blocks of {} warps", num_warps_per_block * THREADS_PER_WARP, latency, num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("barrier", run_reduction(true, num_blocks, num_warps_per_block, latency));
+        table.print_result("kernel launches", run_reduction(false, num_blocks, num_warps_per_block, latency));
+        std::println("");
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <print>
+#include <bit>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "sim.hpp"
+
+// Helpers shared by the benchmarks
+
+namespace bench {
+
+constexpr uint32_t THREADS_PER_WARP = 32;
+
+// x1 only counts the threads of a block, so kernels launched with several blocks compute the global thread id
+// from the block id in x2. The number of threads per block has to be a power of two
+inline auto global_thread_id(sim::Register dst, uint32_t num_warps_per_block) -> std::vector<sim::InstructionBits> {
+    using namespace sim::instructions;
+    return {
+        slli(dst, 2_x, std::countr_zero(num_warps_per_block * THREADS_PER_WARP)),
+        add(dst, dst, 1_x),
+    };
+}
+
+template <typename InstructionMemory>
+void push_global_thread_id(InstructionMemory& instruction_mem, sim::Register dst, uint32_t num_warps_per_block) {
+    for (const auto& instruction : global_thread_id(dst, num_warps_per_block)) {
+        instruction_mem.push_instruction(instruction);
+    }
+}
+
+struct Column {
+    std::string_view header;
+    std::size_t width;
+};
+
+// Table of results, one row per configuration. A result is either a single number or a struct whose columns()
+// returns a tuple with the values of the columns, floating-point values are printed with two decimals
+class Table {
+public:
+    Table(std::string_view name_header, std::size_t name_width, std::vector<Column> columns)
+        : name_header(name_header), name_width(name_width), columns(std::move(columns)) {}
+
+    void print_header() const {
+        auto line = std::format("{:<{}}", name_header, name_width);
+        for (const auto& column : columns) {
+            line += std::format(" | {:>{}}", column.header, column.width);
+        }
+        std::println("{}", line);
+    }
+
+    template <typename Result>
+    void print_result(std::string_view name, const std::optional<Result>& result) const {
+        if (!result) {
+            std::println("{:<{}} | did not finish", name, name_width);
+            return;
+        }
+        if constexpr (std::is_arithmetic_v<Result>) {
+            print_row(name, std::tuple{*result});
+        } else {
+            print_row(name, result->columns());
+        }
+    }
+
+private:
+    std::string_view name_header;
+    std::size_t name_width;
+    std::vector<Column> columns;
+
+    template <typename... Values>
+    void print_row(std::string_view name, const std::tuple<Values...>& values) const {
+        auto line = std::format("{:<{}}", name, name_width);
+        auto column = columns.begin();
+        std::apply([&](const auto&... value) {
+            ((line += format_value(value, (column++)->width)), ...);
+        }, values);
+        std::println("{}", line);
+    }
+
+    template <typename Value>
+    static auto format_value(const Value& value, std::size_t width) -> std::string {
+        if constexpr (std::is_floating_point_v<Value>) {
+            return std::format(" | {:>{}.2f}", value, width);
+        } else {
+            return std::format(" | {:>{}}", value, width);
+        }
+    }
+};
+
+}
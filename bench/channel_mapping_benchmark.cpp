@@ -0,0 +1,86 @@
+#include <print>
+#include "Vgpu.h"
+#include "Vgpu_interleaved_channels.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Channel mapping benchmark
+// Runs strided copies against a banked data memory, once with requests assigned to any idle channel and once
+// with address-interleaved channels, and reports the cycles requests spent waiting for a busy bank
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData OUTPUT_ADDRESS = 4096;
+
+struct BenchmarkResult {
+    uint32_t cycles;
+    uint64_t bank_conflict_cycles;
+
+    auto columns() const {
+        return std::tuple{cycles, bank_conflict_cycles};
+    }
+};
+
+// out[i] = in[i << stride_shift]
+template <typename Gpu>
+auto run_copy(uint32_t num_blocks, uint32_t num_warps_per_block, IData stride_shift) -> std::optional<BenchmarkResult> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = 10;
+    data_mem.bank_busy_cycles = 4;
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < (num_threads << stride_shift); i++) {
+        data_mem.push_data(i + 3);
+    }
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(slli(5_x, 9_x, stride_shift));
+    instruction_mem.push_instruction(lw(6_x, 5_x, 0));
+    instruction_mem.push_instruction(lui(7_x, OUTPUT_ADDRESS >> 12));
+    instruction_mem.push_instruction(add(7_x, 7_x, 9_x));
+    instruction_mem.push_instruction(sw(7_x, 6_x, 0));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        const auto expected = (i << stride_shift) + 3;
+        if (data_mem[OUTPUT_ADDRESS + i] != expected) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], expected);
+            return std::nullopt;
+        }
+    }
+
+    return BenchmarkResult{
+        .cycles = *cycles,
+        .bank_conflict_cycles = data_mem.bank_conflict_cycles,
+    };
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"mapping", 12, {{"cycles", 10}, {"bank conflicts", 15}}};
+
+    for (auto stride_shift : {0u, 2u, 3u}) {
+        std::println("Copy with a stride of {} word(s), {} blocks of {} warps", 1u << stride_shift, num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("any channel", run_copy<Vgpu>(num_blocks, num_warps_per_block, stride_shift));
+        table.print_result("interleaved", run_copy<Vgpu_interleaved_channels>(num_blocks, num_warps_per_block, stride_shift));
+        std::println("");
+    }
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <print>
+#include "Vgpu.h"
+#include "Vgpu_no_coalescing.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Memory coalescing benchmark
+// Copies an array with consecutive and with strided addresses on a GPU with and without coalescing
+// in the data caches, and reports how many requests were served per cache transaction
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 1'000'000;
+constexpr IData OUTPUT_ADDRESS = 1536;
+
+struct BenchmarkResult {
+    uint32_t cycles;
+    IData requests;
+    IData transactions;
+
+    auto columns() const {
+        return std::tuple{cycles, requests, transactions, transactions == 0 ? 0.0 : (double)requests / (double)transactions};
+    }
+};
+
+// out[i] = in[i << stride_shift]
+template <typename Gpu>
+auto run_copy(uint32_t num_blocks, uint32_t num_warps_per_block, IData stride_shift) -> std::optional<BenchmarkResult> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < (num_threads << stride_shift); i++) {
+        data_mem.push_data(i + 7);
+    }
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(slli(5_x, 9_x, stride_shift));
+    instruction_mem.push_instruction(lw(6_x, 5_x, 0));
+    instruction_mem.push_instruction(sw(9_x, 6_x, OUTPUT_ADDRESS));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        const auto expected = (i << stride_shift) + 7;
+        if (data_mem[OUTPUT_ADDRESS + i] != expected) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], expected);
+            return std::nullopt;
+        }
+    }
+
+    return BenchmarkResult{
+        .cycles = *cycles,
+        .requests = top.perf_dcache_hits + top.perf_dcache_misses,
+        .transactions = top.perf_dcache_transactions,
+    };
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"config", 14, {{"cycles", 10}, {"requests", 10}, {"transactions", 12}, {"efficiency", 10}}};
+
+    for (auto stride_shift : {0u, 2u}) {
+        std::println("Copy with a stride of {} word(s), {} blocks of {} warps", 1u << stride_shift, num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("coalescing", run_copy<Vgpu>(num_blocks, num_warps_per_block, stride_shift));
+        table.print_result("no coalescing", run_copy<Vgpu_no_coalescing>(num_blocks, num_warps_per_block, stride_shift));
+        std::println("");
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <print>
+#include "Vgpu.h"
+#include "Vgpu_no_dcache.h"
+#include "Vgpu_dcache_write_back.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Data cache benchmark
+// Runs a 3-point stencil, where every input word is loaded by three different threads, on a GPU
+// without data caches and with write-through and write-back data caches
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 1'000'000;
+constexpr IData OUTPUT_ADDRESS = 1024;
+
+struct BenchmarkResult {
+    uint32_t cycles;
+    IData dcache_hits;
+    IData dcache_misses;
+
+    auto columns() const {
+        return std::tuple{cycles, dcache_hits, dcache_misses};
+    }
+};
+
+// out[i] = in[i] + in[i + 1] + in[i + 2]
+template <typename Gpu>
+auto run_stencil(uint32_t num_blocks, uint32_t num_warps_per_block) -> std::optional<BenchmarkResult> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads + 2; i++) {
+        data_mem.push_data(i);
+    }
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(lw(5_x, 9_x, 0));
+    instruction_mem.push_instruction(lw(6_x, 9_x, 1));
+    instruction_mem.push_instruction(lw(7_x, 9_x, 2));
+    instruction_mem.push_instruction(add(5_x, 5_x, 6_x));
+    instruction_mem.push_instruction(add(5_x, 5_x, 7_x));
+    instruction_mem.push_instruction(sw(9_x, 5_x, OUTPUT_ADDRESS));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        const auto expected = 3 * i + 3;
+        if (data_mem[OUTPUT_ADDRESS + i] != expected) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], expected);
+            return std::nullopt;
+        }
+    }
+
+    return BenchmarkResult{
+        .cycles = *cycles,
+        .dcache_hits = top.perf_dcache_hits,
+        .dcache_misses = top.perf_dcache_misses,
+    };
+}
+
+int main() {
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"config", 14, {{"cycles", 10}, {"hits", 10}, {"misses", 10}}};
+
+    for (auto num_blocks : {2u, 8u}) {
+        std::println("3-point stencil, {} blocks of {} warps", num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("no dcache", run_stencil<Vgpu_no_dcache>(num_blocks, num_warps_per_block));
+        table.print_result("write-through", run_stencil<Vgpu>(num_blocks, num_warps_per_block));
+        table.print_result("write-back", run_stencil<Vgpu_dcache_write_back>(num_blocks, num_warps_per_block));
+        std::println("");
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <print>
+#include <vector>
+#include "Vgpu.h"
+#include "Vgpu_no_zero_mask_skip.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Divergence benchmark
+// Nested if/else regions branching on the bits of a value per thread, with the execution mask saved and restored
+// by scalar instructions in software, and with the split/else/join mask stack, which also skips paths no lane takes.
+// The values are the same for all lanes of a warp (uniform) or differ between neighbouring lanes (divergent).
+// Both run on cores that skip vector instructions of warps without active lanes and on cores that execute them
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData INPUT_ADDRESS = 1024;
+constexpr IData OUTPUT_ADDRESS = 4096;
+constexpr uint32_t NUM_LEVELS = 4;
+constexpr uint32_t PATH_LENGTH = 8;
+
+struct Result {
+    uint32_t cycles;
+    uint32_t instructions;
+    uint32_t zero_mask_skips;
+
+    auto columns() const {
+        return std::tuple{cycles, instructions, zero_mask_skips};
+    }
+};
+
+// The work on either path of a level, x7 accumulates the result of the thread
+auto path(IData value) -> std::vector<sim::InstructionBits> {
+    auto body = std::vector<sim::InstructionBits>{};
+    for (auto i = 0u; i < PATH_LENGTH; i++) {
+        body.push_back(addi(7_x, 7_x, value));
+    }
+    return body;
+}
+
+// if (x5 & (1 << level)) { then path; next level } else { else path }
+auto region(bool use_mask_stack, uint32_t level) -> std::vector<sim::InstructionBits> {
+    if (level == NUM_LEVELS) {
+        return {};
+    }
+
+    auto then_body = path(1 << level);
+    auto nested = region(use_mask_stack, level + 1);
+    then_body.insert(then_body.end(), nested.begin(), nested.end());
+    const auto else_body = path(16);
+
+    // Predicate in s2 for the mask stack, in s(20 + level) when it is needed again for the else path
+    const auto predicate = use_mask_stack ? 2_s : sim::Register{20 + level, sim::RegisterType::SCALAR};
+    const auto saved_mask = sim::Register{10 + level, sim::RegisterType::SCALAR};
+
+    auto code = std::vector<sim::InstructionBits>{
+        andi(6_x, 5_x, 1 << level),
+        sx_slt(predicate, 0_x, 6_x),
+    };
+    if (use_mask_stack) {
+        code.push_back(split(predicate, then_body.size() + 1));
+        code.insert(code.end(), then_body.begin(), then_body.end());
+        code.push_back(else_(else_body.size() + 1));
+        code.insert(code.end(), else_body.begin(), else_body.end());
+        code.push_back(join());
+    } else {
+        code.push_back(addi(saved_mask, 1_s, 0).make_scalar());
+        code.push_back(and_(1_s, saved_mask, predicate).make_scalar());
+        code.insert(code.end(), then_body.begin(), then_body.end());
+        code.push_back(xori(3_s, predicate, 0xfff).make_scalar());
+        code.push_back(and_(1_s, saved_mask, 3_s).make_scalar());
+        code.insert(code.end(), else_body.begin(), else_body.end());
+        code.push_back(addi(1_s, saved_mask, 0).make_scalar());
+    }
+    return code;
+}
+
+auto expected_result(uint32_t value) -> uint32_t {
+    auto result = 0u;
+    for (auto level = 0u; level < NUM_LEVELS; level++) {
+        if (!(value & (1 << level))) {
+            return result + 16 * PATH_LENGTH;
+        }
+        result += (1 << level) * PATH_LENGTH;
+    }
+    return result;
+}
+
+template <typename Gpu>
+auto run_nested_branches(bool use_mask_stack, bool uniform, uint32_t num_blocks, uint32_t num_warps_per_block) -> std::optional<Result> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads; i++) {
+        data_mem[INPUT_ADDRESS + i] = uniform ? i / THREADS_PER_WARP : i;
+    }
+
+    // x9 holds the global thread id, x5 the value of the thread
+    auto program = bench::global_thread_id(9_x, num_warps_per_block);
+    program.insert(program.end(), {
+        lw(5_x, 9_x, INPUT_ADDRESS),
+        addi(7_x, 0_x, 0),
+    });
+    const auto branches = region(use_mask_stack, 0);
+    program.insert(program.end(), branches.begin(), branches.end());
+    program.push_back(sw(9_x, 7_x, OUTPUT_ADDRESS));
+    program.push_back(halt());
+
+    for (const auto& instruction : program) {
+        instruction_mem.push_instruction(instruction);
+    }
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        const auto expected = expected_result(data_mem[INPUT_ADDRESS + i]);
+        if (data_mem[OUTPUT_ADDRESS + i] != expected) {
+            std::println(stderr, "Error: Thread {} computed {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], expected);
+            return std::nullopt;
+        }
+    }
+
+    return Result{*cycles, static_cast<uint32_t>(program.size()), top.perf_zero_mask_skips};
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 8;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"masks", 24, {{"cycles", 10}, {"instructions", 12}, {"skipped", 7}}};
+
+    for (auto uniform : {true, false}) {
+        std::println("{} nested if/else regions, {} values per warp, {} blocks of {} warps", NUM_LEVELS, uniform ? "uniform" : "divergent", num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("software, no skipping", run_nested_branches<Vgpu_no_zero_mask_skip>(false, uniform, num_blocks, num_warps_per_block));
+        table.print_result("software", run_nested_branches<Vgpu>(false, uniform, num_blocks, num_warps_per_block));
+        table.print_result("mask stack, no skipping", run_nested_branches<Vgpu_no_zero_mask_skip>(true, uniform, num_blocks, num_warps_per_block));
+        table.print_result("mask stack", run_nested_branches<Vgpu>(true, uniform, num_blocks, num_warps_per_block));
+        std::println("");
+    }
+
+    return 0;
+}
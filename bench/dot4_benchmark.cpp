@@ -0,0 +1,123 @@
+#include <print>
+#include <bit>
+#include <vector>
+#include "Vgpu.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Dot4 benchmark
+// Quantized dot product of two vectors of signed 8-bit values per thread, packed four to a word.
+// The bytes are unpacked and multiplied with mul and add, unpacked and multiplied with mac,
+// or multiplied and summed a word at a time with dot4
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData INPUT_ADDRESS = 1024;     // The pairs of packed words are interleaved, a[k] is followed by b[k]
+constexpr IData OUTPUT_ADDRESS = 512;
+constexpr uint32_t NUM_WORDS = 4;
+
+enum class Kernel {
+    MUL_ADD,
+    MAC,
+    DOT4,
+};
+
+struct Result {
+    uint32_t cycles;
+    uint32_t instructions;
+
+    auto columns() const {
+        return std::tuple{cycles, instructions};
+    }
+};
+
+auto run_dot_product(Kernel kernel, uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency) -> std::optional<Result> {
+    auto top = Vgpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = latency;
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads * NUM_WORDS * 2; i++) {
+        data_mem[INPUT_ADDRESS + i] = i * 0x9e3779b9u;
+    }
+
+    // x9 holds the global thread id, x13 the index of the first word of the thread, x12 the dot product
+    auto program = bench::global_thread_id(9_x, num_warps_per_block);
+    program.insert(program.end(), {
+        slli(13_x, 9_x, std::countr_zero(NUM_WORDS * 2)),
+        addi(12_x, 0_x, 0),
+    });
+    for (auto k = 0u; k < NUM_WORDS; k++) {
+        program.push_back(lw(5_x, 13_x, INPUT_ADDRESS + 2 * k));
+        program.push_back(lw(6_x, 13_x, INPUT_ADDRESS + 2 * k + 1));
+        if (kernel == Kernel::DOT4) {
+            program.push_back(dot4(12_x, 5_x, 6_x));
+            continue;
+        }
+        // Sign-extend byte j of both words by shifting it to the top and back
+        for (auto j = 0u; j < 4; j++) {
+            program.push_back(slli(7_x, 5_x, 24 - 8 * j));
+            program.push_back(srai(7_x, 7_x, 24));
+            program.push_back(slli(8_x, 6_x, 24 - 8 * j));
+            program.push_back(srai(8_x, 8_x, 24));
+            if (kernel == Kernel::MAC) {
+                program.push_back(mac(12_x, 7_x, 8_x));
+            } else {
+                program.push_back(mul(11_x, 7_x, 8_x));
+                program.push_back(add(12_x, 12_x, 11_x));
+            }
+        }
+    }
+    program.push_back(sw(9_x, 12_x, OUTPUT_ADDRESS));
+    program.push_back(halt());
+
+    for (const auto& instruction : program) {
+        instruction_mem.push_instruction(instruction);
+    }
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        auto expected = 0;
+        for (auto k = 0u; k < NUM_WORDS; k++) {
+            const auto pair = INPUT_ADDRESS + (i * NUM_WORDS + k) * 2;
+            for (auto j = 0u; j < 4; j++) {
+                expected += static_cast<int8_t>(data_mem[pair] >> (8 * j)) * static_cast<int8_t>(data_mem[pair + 1] >> (8 * j));
+            }
+        }
+        if (data_mem[OUTPUT_ADDRESS + i] != static_cast<IData>(expected)) {
+            std::println(stderr, "Error: Thread {} computed {} instead of {}", i, static_cast<int32_t>(data_mem[OUTPUT_ADDRESS + i]), expected);
+            return std::nullopt;
+        }
+    }
+
+    return Result{*cycles, static_cast<uint32_t>(program.size())};
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"multiply", 10, {{"cycles", 10}, {"instructions", 12}}};
+
+    for (auto latency : {0u, 20u}) {
+        std::println("Dot product of {} packed 8-bit values per thread, memory latency of {} cycles, {} blocks of {} warps", NUM_WORDS * 4, latency, num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("mul, add", run_dot_product(Kernel::MUL_ADD, num_blocks, num_warps_per_block, latency));
+        table.print_result("mac", run_dot_product(Kernel::MAC, num_blocks, num_warps_per_block, latency));
+        table.print_result("dot4", run_dot_product(Kernel::DOT4, num_blocks, num_warps_per_block, latency));
+        std::println("");
+    }
+
+    return 0;
+}
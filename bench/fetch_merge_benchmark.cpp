@@ -0,0 +1,88 @@
+#include <print>
+#include "Vgpu_no_icache.h"
+#include "Vgpu_no_fetch_merge.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Fetch merging benchmark
+// Runs a straight-line kernel on GPUs without instruction caches, whose fetchers all read the program memory directly,
+// with and without merging fetches of the same instruction, and reports the merged fetches and the channel wait cycles
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData OUTPUT_ADDRESS = 1024;
+
+template <typename T, std::size_t N>
+constexpr auto array_size(const VlUnpacked<T, N>&) -> std::size_t {
+    return N;
+}
+
+struct BenchmarkResult {
+    uint32_t cycles;
+    IData merged_fetches;
+    uint64_t fetch_wait_cycles;
+
+    auto columns() const {
+        return std::tuple{cycles, merged_fetches, fetch_wait_cycles};
+    }
+};
+
+// out[i] = i + num_increments
+template <typename Gpu>
+auto run_kernel(uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency, uint32_t num_increments) -> std::optional<BenchmarkResult> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    instruction_mem.latency = latency;
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(addi(6_x, 9_x, 0));
+    for (auto i = 0u; i < num_increments; i++) {
+        instruction_mem.push_instruction(addi(6_x, 6_x, 1));
+    }
+    instruction_mem.push_instruction(sw(9_x, 6_x, OUTPUT_ADDRESS));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads; i++) {
+        if (data_mem[OUTPUT_ADDRESS + i] != i + num_increments) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], i + num_increments);
+            return std::nullopt;
+        }
+    }
+
+    auto result = BenchmarkResult{ .cycles = *cycles, .merged_fetches = top.perf_merged_fetches, .fetch_wait_cycles = 0 };
+    for (auto i = 0u; i < array_size(top.perf_instruction_mem_wait_cycles); i++) {
+        result.fetch_wait_cycles += top.perf_instruction_mem_wait_cycles[i];
+    }
+    return result;
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 4;
+    constexpr uint32_t num_increments = 32;
+
+    const auto table = bench::Table{"fetches", 10, {{"cycles", 10}, {"merged fetches", 14}, {"wait cycles", 12}}};
+
+    for (auto latency : {0u, 20u}) {
+        std::println("Straight-line kernel, instruction memory latency of {} cycles, {} blocks of {} warps", latency, num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("merged", run_kernel<Vgpu_no_icache>(num_blocks, num_warps_per_block, latency, num_increments));
+        table.print_result("separate", run_kernel<Vgpu_no_fetch_merge>(num_blocks, num_warps_per_block, latency, num_increments));
+        std::println("");
+    }
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <print>
+#include "Vgpu.h"
+#include "Vgpu_no_icache.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Instruction cache benchmark
+// Runs the same kernel on a GPU with and without per-core instruction caches and compares
+// the number of cycles warps spend waiting on instruction fetches
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 1'000'000;
+
+struct BenchmarkResult {
+    uint32_t cycles;
+    IData fetch_stall_cycles;
+    IData icache_hits;
+    IData icache_misses;
+
+    auto columns() const {
+        return std::tuple{cycles, fetch_stall_cycles, icache_hits, icache_misses};
+    }
+};
+
+// Every thread increments a register num_increments times and stores the result at its thread id
+template <typename Gpu>
+auto run_kernel(uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t num_increments) -> std::optional<BenchmarkResult> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(addi(5_x, 0_x, 0));
+    for (auto i = 0u; i < num_increments; i++) {
+        instruction_mem.push_instruction(addi(5_x, 5_x, 1));
+    }
+    instruction_mem.push_instruction(sw(9_x, 5_x, 0));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads; i++) {
+        if (data_mem[i] != num_increments) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[i], num_increments);
+            return std::nullopt;
+        }
+    }
+
+    return BenchmarkResult{
+        .cycles = *cycles,
+        .fetch_stall_cycles = top.perf_fetch_stall_cycles,
+        .icache_hits = top.perf_icache_hits,
+        .icache_misses = top.perf_icache_misses,
+    };
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 8;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"config", 12, {{"cycles", 10}, {"fetch stalls", 12}, {"hits", 10}, {"misses", 10}}};
+
+    for (auto num_increments : {8u, 32u, 128u}) {
+        std::println("Kernel with {} instructions, {} blocks of {} warps", num_increments + 5, num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("icache", run_kernel<Vgpu>(num_blocks, num_warps_per_block, num_increments));
+        table.print_result("no icache", run_kernel<Vgpu_no_icache>(num_blocks, num_warps_per_block, num_increments));
+        std::println("");
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <print>
+#include "Vgpu.h"
+#include "Vgpu_single_outstanding.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Memory latency benchmark
+// Copies an array against a memory model with increasing latency, on a GPU whose memory channels
+// can have several requests in flight and on one that waits for each response before sending the next request
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData OUTPUT_ADDRESS = 2048;
+
+// out[i] = in[4 * i] + 1, the stride makes every lane miss in the data cache
+template <typename Gpu>
+auto run_copy(uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency) -> std::optional<uint32_t> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = latency;
+    data_mem.latency_jitter = latency / 4;
+    instruction_mem.latency = latency;
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads * 4; i++) {
+        data_mem.push_data(i);
+    }
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(slli(5_x, 9_x, 2));
+    instruction_mem.push_instruction(lw(6_x, 5_x, 0));
+    instruction_mem.push_instruction(addi(6_x, 6_x, 1));
+    instruction_mem.push_instruction(sw(9_x, 6_x, OUTPUT_ADDRESS));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        if (data_mem[OUTPUT_ADDRESS + i] != 4 * i + 1) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], 4 * i + 1);
+            return std::nullopt;
+        }
+    }
+
+    return cycles;
+}
+
+struct Speedup {
+    uint32_t cycles;
+    double speedup;
+
+    auto columns() const {
+        return std::tuple{cycles, speedup};
+    }
+};
+
+auto speedup_over(const std::optional<uint32_t>& cycles, const std::optional<uint32_t>& baseline_cycles) -> std::optional<Speedup> {
+    if (!cycles) {
+        return std::nullopt;
+    }
+    return Speedup{*cycles, baseline_cycles ? (double)*baseline_cycles / (double)*cycles : 0.0};
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"config", 18, {{"cycles", 10}, {"speedup", 10}}};
+
+    for (auto latency : {0u, 20u, 100u}) {
+        std::println("Strided copy with a memory latency of {} cycles, {} blocks of {} warps", latency, num_blocks, num_warps_per_block);
+        table.print_header();
+        const auto baseline_cycles = run_copy<Vgpu_single_outstanding>(num_blocks, num_warps_per_block, latency);
+        table.print_result("single outstanding", speedup_over(baseline_cycles, baseline_cycles));
+        table.print_result("pipelined", speedup_over(run_copy<Vgpu>(num_blocks, num_warps_per_block, latency), baseline_cycles));
+        std::println("");
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <print>
+#include <bit>
+#include <vector>
+#include "Vgpu.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Multiply benchmark
+// Dot product of two vectors of 8-bit values per thread, with the mul instruction and with a branchless
+// shift-and-add multiplication, as kernels had to do before the ALUs could multiply
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData INPUT_ADDRESS = 1024;     // The pairs of values are interleaved, a[k] is followed by b[k]
+constexpr IData OUTPUT_ADDRESS = 512;
+constexpr uint32_t VECTOR_LENGTH = 8;
+constexpr uint32_t VALUE_BITS = 8;
+
+struct Result {
+    uint32_t cycles;
+    uint32_t instructions;
+
+    auto columns() const {
+        return std::tuple{cycles, instructions};
+    }
+};
+
+auto run_dot_product(bool use_mul, uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency) -> std::optional<Result> {
+    auto top = Vgpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = latency;
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads * VECTOR_LENGTH * 2; i++) {
+        data_mem[INPUT_ADDRESS + i] = (i * 37 + 11) % (1 << VALUE_BITS);
+    }
+
+    // x9 holds the global thread id, x13 the index of the first value of the thread, x12 the dot product
+    auto program = bench::global_thread_id(9_x, num_warps_per_block);
+    program.insert(program.end(), {
+        slli(13_x, 9_x, std::countr_zero(VECTOR_LENGTH * 2)),
+        addi(12_x, 0_x, 0),
+    });
+    for (auto k = 0u; k < VECTOR_LENGTH; k++) {
+        program.push_back(lw(5_x, 13_x, INPUT_ADDRESS + 2 * k));
+        program.push_back(lw(6_x, 13_x, INPUT_ADDRESS + 2 * k + 1));
+        if (use_mul) {
+            program.push_back(mul(11_x, 5_x, 6_x));
+            program.push_back(add(12_x, 12_x, 11_x));
+        } else {
+            // Add a << bit for every set bit of b, the bit is turned into an all-ones or all-zeros mask
+            for (auto bit = 0u; bit < VALUE_BITS; bit++) {
+                program.push_back(srli(10_x, 6_x, bit));
+                program.push_back(andi(10_x, 10_x, 1));
+                program.push_back(sub(10_x, 0_x, 10_x));
+                program.push_back(slli(11_x, 5_x, bit));
+                program.push_back(and_(11_x, 11_x, 10_x));
+                program.push_back(add(12_x, 12_x, 11_x));
+            }
+        }
+    }
+    program.push_back(sw(9_x, 12_x, OUTPUT_ADDRESS));
+    program.push_back(halt());
+
+    for (const auto& instruction : program) {
+        instruction_mem.push_instruction(instruction);
+    }
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        auto expected = 0u;
+        for (auto k = 0u; k < VECTOR_LENGTH; k++) {
+            const auto pair = INPUT_ADDRESS + (i * VECTOR_LENGTH + k) * 2;
+            expected += data_mem[pair] * data_mem[pair + 1];
+        }
+        if (data_mem[OUTPUT_ADDRESS + i] != expected) {
+            std::println(stderr, "Error: Thread {} computed {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], expected);
+            return std::nullopt;
+        }
+    }
+
+    return Result{*cycles, static_cast<uint32_t>(program.size())};
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"multiply", 14, {{"cycles", 10}, {"instructions", 12}}};
+
+    for (auto latency : {0u, 20u}) {
+        std::println("Dot product of {} values per thread, memory latency of {} cycles, {} blocks of {} warps", VECTOR_LENGTH, latency, num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("mul", run_dot_product(true, num_blocks, num_warps_per_block, latency));
+        table.print_result("shift and add", run_dot_product(false, num_blocks, num_warps_per_block, latency));
+        std::println("");
+    }
+
+    return 0;
+}
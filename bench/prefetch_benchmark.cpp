@@ -0,0 +1,89 @@
+#include <print>
+#include "Vgpu.h"
+#include "Vgpu_no_prefetch.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Instruction prefetch benchmark
+// Runs a straight-line kernel and a kernel that jumps over every other instruction against a slow instruction
+// memory, with fetchers that prefetch the following instructions and with fetchers that fetch on demand
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData OUTPUT_ADDRESS = 1024;
+
+struct BenchmarkResult {
+    uint32_t cycles;
+    IData fetch_stall_cycles;
+
+    auto columns() const {
+        return std::tuple{cycles, fetch_stall_cycles};
+    }
+};
+
+// out[i] = i + num_increments, with a taken jump before each increment if with_jumps is set
+template <typename Gpu>
+auto run_kernel(uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency, uint32_t num_increments, bool with_jumps) -> std::optional<BenchmarkResult> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    instruction_mem.latency = latency;
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(addi(6_x, 9_x, 0));
+    for (auto i = 0u; i < num_increments; i++) {
+        if (with_jumps) {
+            // Skips the next instruction, which would corrupt the result
+            instruction_mem.push_instruction(jal(10_s, 2));
+            instruction_mem.push_instruction(addi(6_x, 6_x, 100));
+        }
+        instruction_mem.push_instruction(addi(6_x, 6_x, 1));
+    }
+    instruction_mem.push_instruction(sw(9_x, 6_x, OUTPUT_ADDRESS));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads; i++) {
+        if (data_mem[OUTPUT_ADDRESS + i] != i + num_increments) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], i + num_increments);
+            return std::nullopt;
+        }
+    }
+
+    return BenchmarkResult{
+        .cycles = *cycles,
+        .fetch_stall_cycles = top.perf_fetch_stall_cycles,
+    };
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 2;
+    constexpr uint32_t num_increments = 32;
+
+    const auto table = bench::Table{"fetcher", 12, {{"cycles", 10}, {"fetch stalls", 12}}};
+
+    for (auto with_jumps : {false, true}) {
+        for (auto latency : {0u, 20u}) {
+            std::println("{} {} additions, instruction memory latency of {} cycles, {} blocks of {} warps",
+                with_jumps ? "Jumps between" : "Straight-line", num_increments, latency, num_blocks, num_warps_per_block);
+            table.print_header();
+            table.print_result("prefetch", run_kernel<Vgpu>(num_blocks, num_warps_per_block, latency, num_increments, with_jumps));
+            table.print_result("on demand", run_kernel<Vgpu_no_prefetch>(num_blocks, num_warps_per_block, latency, num_increments, with_jumps));
+            std::println("");
+        }
+    }
+
+    return 0;
+}
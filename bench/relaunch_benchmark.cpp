@@ -0,0 +1,70 @@
+#include <print>
+#include "Vgpu.h"
+#include "Vgpu_block_reset.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Block relaunch benchmark
+// Runs kernels made of many short blocks, on cores that start the next block of a slot in place
+// and on cores that reset the slot before the dispatcher hands it the next block
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData OUTPUT_ADDRESS = 1024;
+
+// out[i] = block_id + num_additions
+template <typename Gpu>
+auto run_kernel(uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t num_additions) -> std::optional<uint32_t> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+
+    const auto block_size = num_warps_per_block * THREADS_PER_WARP;
+    const auto num_threads = num_blocks * block_size;
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(addi(5_x, 2_x, 0));
+    for (auto i = 0u; i < num_additions; i++) {
+        instruction_mem.push_instruction(addi(5_x, 5_x, 1));
+    }
+    instruction_mem.push_instruction(sw(9_x, 5_x, OUTPUT_ADDRESS));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        if (data_mem[OUTPUT_ADDRESS + i] != i / block_size + num_additions) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], i / block_size + num_additions);
+            return std::nullopt;
+        }
+    }
+
+    return cycles;
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 64;
+
+    const auto table = bench::Table{"next block", 10, {{"cycles", 10}}};
+
+    for (auto num_warps_per_block : {1u, 2u}) {
+        for (auto num_additions : {0u, 8u, 32u}) {
+            std::println("{} blocks of {} warps, {} additions per block", num_blocks, num_warps_per_block, num_additions);
+            table.print_header();
+            table.print_result("relaunch", run_kernel<Vgpu>(num_blocks, num_warps_per_block, num_additions));
+            table.print_result("reset", run_kernel<Vgpu_block_reset>(num_blocks, num_warps_per_block, num_additions));
+            std::println("");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <print>
+#include <bit>
+#include "Vgpu.h"
+#include "Vgpu_gto_scheduler.h"
+#include "Vgpu_two_level_scheduler.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Warp scheduler benchmark
+// Runs a latency-sensitive and a cache-sensitive kernel under each warp scheduling policy and reports
+// the cycles in which the cores had no warp able to make progress
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData OUTPUT_ADDRESS = 1 << 14;
+
+struct BenchmarkResult {
+    uint32_t cycles;
+    IData scheduler_idle_cycles;
+    IData dcache_hits;
+    IData dcache_misses;
+
+    auto columns() const {
+        return std::tuple{cycles, scheduler_idle_cycles, dcache_hits, dcache_misses};
+    }
+};
+
+// Latency-sensitive: out[i] = in[i] + num_increments, the additions do not depend on the load
+// Cache-sensitive: out[i] = sum of in[16 * i + k] for k < 16, every thread walks its own four cache lines
+template <typename Gpu>
+auto run_kernel(bool cache_sensitive, uint32_t num_blocks, uint32_t num_warps_per_block) -> std::optional<BenchmarkResult> {
+    constexpr uint32_t num_increments = 16;
+    constexpr uint32_t num_loads = 16;
+
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = 50;
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads * num_loads; i++) {
+        data_mem.push_data(i);
+    }
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    if (cache_sensitive) {
+        instruction_mem.push_instruction(slli(5_x, 9_x, std::countr_zero(num_loads)));
+        instruction_mem.push_instruction(addi(7_x, 0_x, 0));
+        for (auto k = 0u; k < num_loads; k++) {
+            instruction_mem.push_instruction(lw(6_x, 5_x, k));
+            instruction_mem.push_instruction(add(7_x, 7_x, 6_x));
+        }
+    } else {
+        instruction_mem.push_instruction(lw(6_x, 9_x, 0));
+        instruction_mem.push_instruction(addi(7_x, 0_x, 0));
+        for (auto k = 0u; k < num_increments; k++) {
+            instruction_mem.push_instruction(addi(7_x, 7_x, 1));
+        }
+        instruction_mem.push_instruction(add(7_x, 7_x, 6_x));
+    }
+    instruction_mem.push_instruction(lui(8_x, OUTPUT_ADDRESS >> 12));
+    instruction_mem.push_instruction(add(8_x, 8_x, 9_x));
+    instruction_mem.push_instruction(sw(8_x, 7_x, 0));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        IData expected = i + num_increments;
+        if (cache_sensitive) {
+            expected = 0;
+            for (auto k = 0u; k < num_loads; k++) {
+                expected += i * num_loads + k;
+            }
+        }
+        if (data_mem[OUTPUT_ADDRESS + i] != expected) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], expected);
+            return std::nullopt;
+        }
+    }
+
+    return BenchmarkResult{
+        .cycles = *cycles,
+        .scheduler_idle_cycles = top.perf_scheduler_idle_cycles,
+        .dcache_hits = top.perf_dcache_hits,
+        .dcache_misses = top.perf_dcache_misses,
+    };
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"policy", 20, {{"cycles", 10}, {"idle cycles", 12}, {"hits", 10}, {"misses", 10}}};
+
+    for (auto cache_sensitive : {false, true}) {
+        std::println("{} kernel, {} blocks of {} warps", cache_sensitive ? "Cache-sensitive" : "Latency-sensitive", num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("loose round-robin", run_kernel<Vgpu>(cache_sensitive, num_blocks, num_warps_per_block));
+        table.print_result("greedy-then-oldest", run_kernel<Vgpu_gto_scheduler>(cache_sensitive, num_blocks, num_warps_per_block));
+        table.print_result("two-level", run_kernel<Vgpu_two_level_scheduler>(cache_sensitive, num_blocks, num_warps_per_block));
+        std::println("");
+    }
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <print>
+#include "Vgpu.h"
+#include "Vgpu_no_scoreboard.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Register scoreboard benchmark
+// Runs a kernel that issues its load before a run of independent additions against a slow memory, on cores whose
+// warps keep issuing until they need the loaded register and on cores whose warps wait for every load to return
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData OUTPUT_ADDRESS = 1024;
+
+// out[i] = in[i] + num_increments
+template <typename Gpu>
+auto run_kernel(uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency, uint32_t num_increments) -> std::optional<uint32_t> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = latency;
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads; i++) {
+        data_mem.push_data(i * 3);
+    }
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(lw(5_x, 9_x, 0));
+    instruction_mem.push_instruction(addi(6_x, 0_x, 0));
+    for (auto i = 0u; i < num_increments; i++) {
+        instruction_mem.push_instruction(addi(6_x, 6_x, 1));
+    }
+    instruction_mem.push_instruction(add(5_x, 5_x, 6_x));
+    instruction_mem.push_instruction(sw(9_x, 5_x, OUTPUT_ADDRESS));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        if (data_mem[OUTPUT_ADDRESS + i] != i * 3 + num_increments) {
+            std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], i * 3 + num_increments);
+            return std::nullopt;
+        }
+    }
+
+    return cycles;
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_increments = 16;
+
+    const auto table = bench::Table{"issue", 14, {{"cycles", 10}}};
+
+    for (auto num_warps_per_block : {1u, 4u}) {
+        for (auto latency : {50u, 200u}) {
+            std::println("Load, {} independent additions, then its use, memory latency of {} cycles, {} blocks of {} warps",
+                num_increments, latency, num_blocks, num_warps_per_block);
+            table.print_header();
+            table.print_result("scoreboard", run_kernel<Vgpu>(num_blocks, num_warps_per_block, latency, num_increments));
+            table.print_result("wait for load", run_kernel<Vgpu_no_scoreboard>(num_blocks, num_warps_per_block, latency, num_increments));
+            std::println("");
+        }
+    }
+
+    return 0;
+}
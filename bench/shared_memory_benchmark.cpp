@@ -0,0 +1,158 @@
+#include <print>
+#include <bit>
+#include "Vgpu.h"
+#include "Vgpu_single_shared_memory_bank.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Shared memory benchmark
+// Strided scratchpad accesses, which conflict in the banks of the scratchpad more often the larger the stride,
+// on cores with banked and with single-bank scratchpads.
+// A warp-wide neighbour sum that reads every input eight times, from global memory and from the scratchpad
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData INPUT_ADDRESS = 1024;
+constexpr IData OUTPUT_ADDRESS = 4096;
+constexpr uint32_t NUM_NEIGHBOURS = 8;
+
+struct Result {
+    uint32_t cycles;
+    uint32_t shared_memory_accesses;
+    uint32_t bank_conflicts;
+
+    auto columns() const {
+        return std::tuple{cycles, shared_memory_accesses, bank_conflicts};
+    }
+};
+
+// Every thread writes its id to word x1 * stride of the scratchpad, reads it back and stores it
+template <typename Gpu>
+auto run_strided(uint32_t stride, uint32_t num_blocks, uint32_t num_warps_per_block) -> std::optional<Result> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    if (std::has_single_bit(stride)) {
+        instruction_mem.push_instruction(slli(8_x, 1_x, std::countr_zero(stride)));
+    } else {
+        // stride = 2^n + 1
+        instruction_mem.push_instruction(slli(8_x, 1_x, std::countr_zero(stride - 1)));
+        instruction_mem.push_instruction(add(8_x, 8_x, 1_x));
+    }
+    instruction_mem.push_instruction(sws(8_x, 9_x, 0));
+    instruction_mem.push_instruction(lws(10_x, 8_x, 0));
+    instruction_mem.push_instruction(sw(9_x, 10_x, OUTPUT_ADDRESS));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        if (data_mem[OUTPUT_ADDRESS + i] != i) {
+            std::println(stderr, "Error: Thread {} read {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], i);
+            return std::nullopt;
+        }
+    }
+
+    return Result{*cycles, top.perf_shared_memory_accesses, top.perf_shared_memory_bank_conflicts};
+}
+
+// out[i] is the sum of the inputs of the NUM_NEIGHBOURS lanes following lane i within its warp (wrapping around)
+template <typename Gpu>
+auto run_neighbour_sum(bool use_shared_memory, uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency) -> std::optional<Result> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = latency;
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads; i++) {
+        data_mem[INPUT_ADDRESS + i] = i * 3 + 1;
+    }
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(andi(13_x, 1_x, THREADS_PER_WARP - 1));   // x13 = lane
+    if (use_shared_memory) {
+        // Stage the inputs of the block in the scratchpad, x11 = first word of the warp
+        instruction_mem.push_instruction(lw(7_x, 9_x, INPUT_ADDRESS));
+        instruction_mem.push_instruction(sws(1_x, 7_x, 0));
+        instruction_mem.push_instruction(sub(11_x, 1_x, 13_x));
+    } else {
+        // x11 = first input of the warp
+        instruction_mem.push_instruction(sub(11_x, 9_x, 13_x));
+    }
+    instruction_mem.push_instruction(addi(12_x, 0_x, 0));
+    for (auto k = 0u; k < NUM_NEIGHBOURS; k++) {
+        instruction_mem.push_instruction(addi(6_x, 13_x, k));
+        instruction_mem.push_instruction(andi(6_x, 6_x, THREADS_PER_WARP - 1));
+        instruction_mem.push_instruction(add(6_x, 6_x, 11_x));
+        if (use_shared_memory) {
+            instruction_mem.push_instruction(lws(7_x, 6_x, 0));
+        } else {
+            instruction_mem.push_instruction(lw(7_x, 6_x, INPUT_ADDRESS));
+        }
+        instruction_mem.push_instruction(add(12_x, 12_x, 7_x));
+    }
+    instruction_mem.push_instruction(sw(9_x, 12_x, OUTPUT_ADDRESS));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        const auto warp_base = i - i % THREADS_PER_WARP;
+        auto expected = 0u;
+        for (auto k = 0u; k < NUM_NEIGHBOURS; k++) {
+            expected += (warp_base + (i + k) % THREADS_PER_WARP) * 3 + 1;
+        }
+        if (data_mem[OUTPUT_ADDRESS + i] != expected) {
+            std::println(stderr, "Error: Thread {} computed {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], expected);
+            return std::nullopt;
+        }
+    }
+
+    return Result{*cycles, top.perf_shared_memory_accesses, top.perf_shared_memory_bank_conflicts};
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 1;
+
+    const auto strided_table = bench::Table{"scratchpad", 14, {{"cycles", 10}, {"accesses", 8}, {"conflicts", 10}}};
+    const auto neighbour_table = bench::Table{"inputs from", 14, {{"cycles", 10}, {"accesses", 8}, {"conflicts", 10}}};
+
+    for (auto stride : {1u, 2u, 8u, 9u, 16u}) {
+        std::println("Shared memory store and load with a stride of {} words, {} blocks of {} warp", stride, num_blocks, num_warps_per_block);
+        strided_table.print_header();
+        strided_table.print_result("32 banks", run_strided<Vgpu>(stride, num_blocks, num_warps_per_block));
+        strided_table.print_result("1 bank", run_strided<Vgpu_single_shared_memory_bank>(stride, num_blocks, num_warps_per_block));
+        std::println("");
+    }
+
+    for (auto latency : {0u, 20u}) {
+        std::println("Sum of {} neighbours per thread, memory latency of {} cycles, {} blocks of {} warp", NUM_NEIGHBOURS, latency, num_blocks, num_warps_per_block);
+        neighbour_table.print_header();
+        neighbour_table.print_result("global memory", run_neighbour_sum<Vgpu>(false, num_blocks, num_warps_per_block, latency));
+        neighbour_table.print_result("scratchpad", run_neighbour_sum<Vgpu>(true, num_blocks, num_warps_per_block, latency));
+        std::println("");
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <print>
+#include <vector>
+#include "Vgpu.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Warp reduction benchmark
+// Sum of the values of every warp, with a single reduction instruction, with a tree of lane shuffles,
+// and with every lane reading the values of its warp back from global memory
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData INPUT_ADDRESS = 1024;
+constexpr IData OUTPUT_ADDRESS = 256;
+
+enum class Method {
+    REDUCTION,
+    SHUFFLE,
+    MEMORY
+};
+
+struct Result {
+    uint32_t cycles;
+    uint32_t instructions;
+
+    auto columns() const {
+        return std::tuple{cycles, instructions};
+    }
+};
+
+auto run_warp_sum(Method method, uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency) -> std::optional<Result> {
+    auto top = Vgpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = latency;
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+    for (auto i = 0u; i < num_threads; i++) {
+        data_mem[INPUT_ADDRESS + i] = i % 13 + 1;
+    }
+
+    // x9 holds the global thread id, x5 the value of the thread
+    auto program = bench::global_thread_id(9_x, num_warps_per_block);
+    program.insert(program.end(), {
+        lw(5_x, 9_x, INPUT_ADDRESS),
+    });
+
+    switch (method) {
+    case Method::REDUCTION:
+        // The sum is written by a scalar store to the output of the first thread of the warp
+        program.push_back(sx_redmin(7_s, 9_x));
+        program.push_back(sx_redadd(5_s, 5_x));
+        program.push_back(sw(7_s, 5_s, OUTPUT_ADDRESS).make_scalar());
+        break;
+    case Method::SHUFFLE:
+        // Every lane adds the partial sum of the lane stride lanes further on, after log2(32) steps all lanes hold the sum
+        for (auto stride = 1u; stride < THREADS_PER_WARP; stride *= 2) {
+            program.push_back(addi(11_x, 1_x, stride));
+            program.push_back(shfl(6_x, 5_x, 11_x));
+            program.push_back(add(5_x, 5_x, 6_x));
+        }
+        program.push_back(sw(9_x, 5_x, OUTPUT_ADDRESS));
+        break;
+    case Method::MEMORY:
+        // Every lane loads all values of its warp, x11 = address of the first value of the warp
+        program.push_back(andi(13_x, 1_x, THREADS_PER_WARP - 1));
+        program.push_back(sub(11_x, 9_x, 13_x));
+        program.push_back(addi(12_x, 0_x, 0));
+        for (auto k = 0u; k < THREADS_PER_WARP; k++) {
+            program.push_back(lw(7_x, 11_x, INPUT_ADDRESS + k));
+            program.push_back(add(12_x, 12_x, 7_x));
+        }
+        program.push_back(sw(9_x, 12_x, OUTPUT_ADDRESS));
+        break;
+    }
+    program.push_back(halt());
+
+    for (const auto& instruction : program) {
+        instruction_mem.push_instruction(instruction);
+    }
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto warp = 0u; warp < num_threads / THREADS_PER_WARP; warp++) {
+        auto expected = 0u;
+        for (auto i = warp * THREADS_PER_WARP; i < (warp + 1) * THREADS_PER_WARP; i++) {
+            expected += i % 13 + 1;
+        }
+        if (data_mem[OUTPUT_ADDRESS + warp * THREADS_PER_WARP] != expected) {
+            std::println(stderr, "Error: Warp {} summed up to {} instead of {}", warp, data_mem[OUTPUT_ADDRESS + warp * THREADS_PER_WARP], expected);
+            return std::nullopt;
+        }
+    }
+
+    return Result{*cycles, static_cast<uint32_t>(program.size())};
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 8;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"warp sum", 14, {{"cycles", 10}, {"instructions", 12}}};
+
+    for (auto latency : {0u, 20u}) {
+        std::println("Sum of {} values per warp, memory latency of {} cycles, {} blocks of {} warps", THREADS_PER_WARP, latency, num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("reduction", run_warp_sum(Method::REDUCTION, num_blocks, num_warps_per_block, latency));
+        table.print_result("shuffles", run_warp_sum(Method::SHUFFLE, num_blocks, num_warps_per_block, latency));
+        table.print_result("global memory", run_warp_sum(Method::MEMORY, num_blocks, num_warps_per_block, latency));
+        std::println("");
+    }
+
+    return 0;
+}
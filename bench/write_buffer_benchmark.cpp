@@ -0,0 +1,72 @@
+#include <print>
+#include "Vgpu.h"
+#include "Vgpu_no_write_buffer.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Posted store benchmark
+// Runs an output-heavy kernel against a slow memory, on cores that post their stores to a write buffer
+// and on cores whose stores wait for the memory to accept them
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData OUTPUT_ADDRESS = 1024;
+
+// out[k * num_threads + i] = i + k for k < num_outputs
+template <typename Gpu>
+auto run_kernel(uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency, uint32_t num_outputs) -> std::optional<uint32_t> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = latency;
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(addi(5_x, 9_x, 0));
+    for (auto k = 0u; k < num_outputs; k++) {
+        instruction_mem.push_instruction(sw(9_x, 5_x, OUTPUT_ADDRESS + k * num_threads));
+        instruction_mem.push_instruction(addi(5_x, 5_x, 1));
+    }
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto k = 0u; k < num_outputs; k++) {
+        for (auto i = 0u; i < num_threads; i++) {
+            if (data_mem[OUTPUT_ADDRESS + k * num_threads + i] != i + k) {
+                std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + k * num_threads + i], i + k);
+                return std::nullopt;
+            }
+        }
+    }
+
+    return cycles;
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 2;
+    constexpr uint32_t num_outputs = 8;
+
+    const auto table = bench::Table{"stores", 14, {{"cycles", 10}}};
+
+    for (auto latency : {0u, 50u, 200u}) {
+        std::println("{} stores per thread, memory latency of {} cycles, {} blocks of {} warps", num_outputs, latency, num_blocks, num_warps_per_block);
+        table.print_header();
+        table.print_result("posted", run_kernel<Vgpu>(num_blocks, num_warps_per_block, latency, num_outputs));
+        table.print_result("acknowledged", run_kernel<Vgpu_no_write_buffer>(num_blocks, num_warps_per_block, latency, num_outputs));
+        std::println("");
+    }
+
+    return 0;
+}
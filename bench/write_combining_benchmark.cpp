@@ -0,0 +1,104 @@
+#include <print>
+#include <bit>
+#include "Vgpu.h"
+#include "Vgpu_no_write_combining.h"
+#include "sim.hpp"
+#include "bench_util.hpp"
+
+// Write combining benchmark
+// Runs kernels that store to the same word several times, and kernels whose consecutive stores fill adjacent words,
+// on cores whose write buffer holds stores to combine them and on cores whose write buffer drains every store at once
+
+using namespace sim::instructions;
+
+constexpr uint32_t NUM_CHANNELS = 8;
+constexpr uint32_t THREADS_PER_WARP = 32;
+constexpr uint32_t MAX_NUM_CYCLES = 10'000'000;
+constexpr IData OUTPUT_ADDRESS = 1024;
+constexpr uint32_t NUM_STORES = 4;
+
+enum class Pattern {
+    Repeated,   // out[i] is updated NUM_STORES times
+    Adjacent    // out[i * NUM_STORES + k] = i + k, one word per instruction
+};
+
+struct Result {
+    uint32_t cycles;
+    uint32_t posted_stores;
+    uint32_t drained_stores;
+
+    auto columns() const {
+        return std::tuple{cycles, posted_stores, drained_stores, static_cast<double>(posted_stores) / drained_stores};
+    }
+};
+
+template <typename Gpu>
+auto run_kernel(Pattern pattern, uint32_t num_blocks, uint32_t num_warps_per_block, uint32_t latency) -> std::optional<Result> {
+    auto top = Gpu{};
+
+    auto instruction_mem = sim::make_instruction_memory<NUM_CHANNELS>(&top);
+    auto data_mem = sim::make_data_memory<NUM_CHANNELS>(&top);
+    data_mem.latency = latency;
+
+    const auto num_threads = num_blocks * num_warps_per_block * THREADS_PER_WARP;
+
+    bench::push_global_thread_id(instruction_mem, 9_x, num_warps_per_block);
+    instruction_mem.push_instruction(addi(5_x, 9_x, 0));
+    if (pattern == Pattern::Repeated) {
+        for (auto k = 0u; k < NUM_STORES; k++) {
+            instruction_mem.push_instruction(sw(9_x, 5_x, OUTPUT_ADDRESS));
+            instruction_mem.push_instruction(addi(5_x, 5_x, 1));
+        }
+    } else {
+        instruction_mem.push_instruction(slli(6_x, 9_x, std::countr_zero(NUM_STORES)));
+        for (auto k = 0u; k < NUM_STORES; k++) {
+            instruction_mem.push_instruction(sw(6_x, 5_x, OUTPUT_ADDRESS + k));
+            instruction_mem.push_instruction(addi(5_x, 5_x, 1));
+        }
+    }
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, num_blocks, num_warps_per_block);
+
+    auto cycles = sim::simulate_cycles(top, instruction_mem, data_mem, MAX_NUM_CYCLES);
+    if (!cycles) {
+        return std::nullopt;
+    }
+
+    for (auto i = 0u; i < num_threads; i++) {
+        if (pattern == Pattern::Repeated) {
+            if (data_mem[OUTPUT_ADDRESS + i] != i + NUM_STORES - 1) {
+                std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i], i + NUM_STORES - 1);
+                return std::nullopt;
+            }
+            continue;
+        }
+        for (auto k = 0u; k < NUM_STORES; k++) {
+            if (data_mem[OUTPUT_ADDRESS + i * NUM_STORES + k] != i + k) {
+                std::println(stderr, "Error: Thread {} stored {} instead of {}", i, data_mem[OUTPUT_ADDRESS + i * NUM_STORES + k], i + k);
+                return std::nullopt;
+            }
+        }
+    }
+
+    return Result{*cycles, top.perf_posted_stores, top.perf_drained_stores};
+}
+
+int main() {
+    constexpr uint32_t num_blocks = 4;
+    constexpr uint32_t num_warps_per_block = 2;
+
+    const auto table = bench::Table{"stores", 12, {{"cycles", 10}, {"posted", 8}, {"drained", 8}, {"efficiency", 10}}};
+
+    for (auto [pattern, description] : {std::pair{Pattern::Repeated, "repeated stores to one word"}, std::pair{Pattern::Adjacent, "stores to adjacent words"}}) {
+        for (auto latency : {0u, 50u}) {
+            std::println("{} {} per thread, memory latency of {} cycles, {} blocks of {} warps", NUM_STORES, description, latency, num_blocks, num_warps_per_block);
+            table.print_header();
+            table.print_result("combined", run_kernel<Vgpu>(pattern, num_blocks, num_warps_per_block, latency));
+            table.print_result("uncombined", run_kernel<Vgpu_no_write_combining>(pattern, num_blocks, num_warps_per_block, latency));
+            std::println("");
+        }
+    }
+
+    return 0;
+}
@@ -41,10 +41,26 @@ auto translate_to_binary(const as::parser::Program& program) -> std::vector<sim:
                     const auto &immediate = std::get<token::Immediate>(operands.immediate_or_label_ref);
                     instruction_bits = sim::instructions::jalr(operands.rd, operands.rs1, immediate.value);
                 }
+            },
+                [&](const as::parser::MaskStackOperands &operands) {
+                // Labels are turned into an offset from this instruction, encoded as a 12-bit two's complement immediate
+                auto offset = IData{};
+                if (std::holds_alternative<token::LabelRef>(operands.immediate_or_label_ref)) {
+                    const auto &label_token = std::get<token::LabelRef>(operands.immediate_or_label_ref);
+                    offset = (program.label_mappings.at(label_token.label_name) - i) & 0xfffu;
+                } else {
+                    offset = std::get<token::Immediate>(operands.immediate_or_label_ref).value;
+                }
+                instruction_bits = sim::instructions::create_itype_instruction(opcode, funct3, 0_s, operands.rs1, offset);
             }
 
         }, program.instructions[i].operands);
 
+        // The opcodes only encode the vector form, s. instructions set the scalar bit on top
+        if (instruction.mnemonic.is_scalar()) {
+            instruction_bits.make_scalar();
+        }
+
         machine_code[i] = instruction_bits;
     }
 
@@ -86,8 +86,9 @@ auto Parser::parse_instruction() -> std::optional<Result> {
     auto mnemonic_token = *chop();
     auto mnemonic = mnemonic_token.as<token::Mnemonic>().mnemonic;
 
-    // HALT
-    if (mnemonic.get_name() == sim::MnemonicName::HALT) {
+    // HALT, BAR, JOIN
+    if (mnemonic.get_name() == sim::MnemonicName::HALT || mnemonic.get_name() == sim::MnemonicName::BAR ||
+        mnemonic.get_name() == sim::MnemonicName::JOIN) {
         return parser::Instruction{.mnemonic = mnemonic};
     }
 
@@ -96,21 +97,31 @@ auto Parser::parse_instruction() -> std::optional<Result> {
         return parse_itype_arithemtic_instruction(mnemonic);
     }
 
-    // ADD, SUB, SLL, SLT, XOR, SRL, SRA, OR, AND, SX_SLT
+    // ADD, SUB, SLL, SLT, XOR, SRL, SRA, OR, AND, SX_SLT, SHFL
     if (parser::is_rtype(mnemonic.get_name())) {
         return parse_rtype_instruction(mnemonic);
     }
 
-    // LB, LH, LW
+    // LB, LH, LW, LWS
     if (parser::is_load_type(mnemonic.get_name())) {
         return parse_load_instruction(mnemonic);
     }
 
-    // SB, SH, SW
+    // SB, SH, SW, SWS
     if (parser::is_store_type(mnemonic.get_name())) {
         return parse_store_instruction(mnemonic);
     }
 
+    // AMOADD.W, AMOSWAP.W, AMOMIN.W, AMOMAX.W, AMOCAS.W
+    if (parser::is_amo(mnemonic.get_name())) {
+        return parse_amo_instruction(mnemonic);
+    }
+
+    // SX_REDADD, SX_REDMIN, SX_REDMAX, SX_REDAND, SX_REDOR
+    if (parser::is_reduction(mnemonic.get_name())) {
+        return parse_reduction_instruction(mnemonic);
+    }
+
     // LUI, AUIPC
     if (parser::is_utype(mnemonic.get_name())) {
         return parse_utype_instruction(mnemonic);
@@ -124,6 +135,11 @@ auto Parser::parse_instruction() -> std::optional<Result> {
         return parse_jal_instruction(mnemonic);
     }
 
+    // SPLIT, ELSE
+    if (mnemonic.is_mask_stack()) {
+        return parse_mask_stack_instruction(mnemonic);
+    }
+
     push_err(std::format("Unknown mnemonic: '{}'", mnemonic.to_str()), mnemonic_token.col);
     return std::nullopt;
 }
@@ -257,6 +273,62 @@ auto Parser::parse_store_instruction(const sim::Mnemonic& mnemonic) -> std::opti
     return instruction;
 }
 
+// <opcode> <rd>, <rs2>, (<rs1>)
+auto Parser::parse_amo_instruction(const sim::Mnemonic& mnemonic) -> std::optional<parser::Instruction> {
+    EXPECT_OR_RETURN(rd, token::Register);
+    EXPECT_OR_RETURN(comma1, token::Comma);
+    EXPECT_OR_RETURN(rs2, token::Register);
+    EXPECT_OR_RETURN(comma2, token::Comma);
+    EXPECT_OR_RETURN(lparen, token::Lparen);
+    EXPECT_OR_RETURN(rs1, token::Register);
+    EXPECT_OR_RETURN(rparen, token::Rparen);
+
+    // The scalar form of the AMO opcode is JAL, so atomics only exist as vector instructions
+    if (mnemonic.is_scalar()) {
+        push_err(std::format("'{}' has no scalar form", mnemonic.to_str()), rd->col);
+        return std::nullopt;
+    }
+
+    CHECK_REG(*rd, false);
+    CHECK_REG(*rs1, false);
+    CHECK_REG(*rs2, false);
+
+    auto instruction = parser::Instruction{
+        .label = {},
+        .mnemonic = mnemonic,
+        .operands = parser::RtypeOperands{
+            .rd = rd->as<token::Register>().register_data,
+            .rs1 = rs1->as<token::Register>().register_data,
+            .rs2 = rs2->as<token::Register>().register_data,
+        },
+    };
+
+    return instruction;
+}
+
+// <opcode> <rd>, <rs1>
+auto Parser::parse_reduction_instruction(const sim::Mnemonic& mnemonic) -> std::optional<parser::Instruction> {
+    EXPECT_OR_RETURN(rd, token::Register);
+    EXPECT_OR_RETURN(comma, token::Comma);
+    EXPECT_OR_RETURN(rs1, token::Register);
+
+    // Like the other vector scalar instructions, the destination register is scalar and the source register is vector
+    CHECK_REG(*rd, true);
+    CHECK_REG(*rs1, false);
+
+    auto instruction = parser::Instruction{
+        .label = {},
+        .mnemonic = mnemonic,
+        .operands = parser::RtypeOperands{
+            .rd = rd->as<token::Register>().register_data,
+            .rs1 = rs1->as<token::Register>().register_data,
+            .rs2 = 0_x,
+        },
+    };
+
+    return instruction;
+}
+
 auto Parser::parse_jal_instruction(const sim::Mnemonic& mnemonic) -> std::optional<parser::Instruction> {
     EXPECT_OR_RETURN(rd, token::Register);
     EXPECT_OR_RETURN(comma, token::Comma);
@@ -309,6 +381,34 @@ auto Parser::parse_jalr_instruction(const sim::Mnemonic& mnemonic) -> std::optio
     };
 }
 
+// SPLIT rs1, target skips to target if no lane of s1 is set in rs1, ELSE target if no lane is left for the else path
+// The target is a label or an offset in instructions, relative to the SPLIT / ELSE:
+// SPLIT rs1, labelref
+// SPLIT rs1, offset
+// ELSE labelref
+// ELSE offset
+auto Parser::parse_mask_stack_instruction(const sim::Mnemonic& mnemonic) -> std::optional<parser::Instruction> {
+    auto rs1 = 0_s;
+    if (mnemonic.get_name() == sim::MnemonicName::SPLIT) {
+        EXPECT_OR_RETURN(predicate, token::Register);
+        EXPECT_OR_RETURN(comma, token::Comma);
+        CHECK_REG(*predicate, true);
+        rs1 = predicate->as<token::Register>().register_data;
+    }
+    EXPECT_OR_RETURN(target, token::LabelRef, token::Immediate);
+
+    auto immediate_or_label_ref = target->is_of_type<token::LabelRef>() ? parser::ImmediateOrLabelref{target->as<token::LabelRef>()}
+                                                                        : parser::ImmediateOrLabelref{target->as<token::Immediate>()};
+
+    return parser::Instruction {
+        .label = {},
+        .mnemonic = mnemonic,
+        .operands = parser::MaskStackOperands {
+            .rs1 = rs1,
+            .immediate_or_label_ref = immediate_or_label_ref
+        }
+    };
+}
 
 auto Parser::parse_directive() -> std::optional<Result> {
     auto token = chop();
@@ -58,8 +58,14 @@ struct JalrOperands {
     ImmediateOrLabelref immediate_or_label_ref;
 };
 
+// SPLIT rs1, target and ELSE target, the target is the first instruction after the skipped path
+struct MaskStackOperands {
+    sim::Register rs1;
+    ImmediateOrLabelref immediate_or_label_ref;
+};
+
 /*using Operands = std::variant<Rtype, Itype, Load, Store, Branch, Jump, Utype, Sx>;*/
-using Operands = std::variant<ItypeOperands, RtypeOperands, StypeOperands, UtypeOperands, JtypeOperands, JalrOperands>;
+using Operands = std::variant<ItypeOperands, RtypeOperands, StypeOperands, UtypeOperands, JtypeOperands, JalrOperands, MaskStackOperands>;
 
 constexpr auto is_itype_arithmetic(sim::MnemonicName name) -> bool {
     return name == sim::MnemonicName::ADDI || name == sim::MnemonicName::SLTI || name == sim::MnemonicName::XORI ||
@@ -71,15 +77,29 @@ constexpr auto is_rtype(sim::MnemonicName name) -> bool {
     return name == sim::MnemonicName::ADD || name == sim::MnemonicName::SUB || name == sim::MnemonicName::SLL ||
            name == sim::MnemonicName::SLT || name == sim::MnemonicName::XOR || name == sim::MnemonicName::SRL ||
            name == sim::MnemonicName::SRA || name == sim::MnemonicName::OR || name == sim::MnemonicName::AND ||
-           name == sim::MnemonicName::SX_SLT;
+           name == sim::MnemonicName::MUL || name == sim::MnemonicName::MULH || name == sim::MnemonicName::DIV ||
+           name == sim::MnemonicName::REM || name == sim::MnemonicName::MAC || name == sim::MnemonicName::DOT4 ||
+           name == sim::MnemonicName::SX_SLT || name == sim::MnemonicName::SHFL;
 }
 
 constexpr auto is_load_type(sim::MnemonicName name) -> bool {
-    return name == sim::MnemonicName::LB || name == sim::MnemonicName::LH || name == sim::MnemonicName::LW;
+    return name == sim::MnemonicName::LB || name == sim::MnemonicName::LH || name == sim::MnemonicName::LW ||
+           name == sim::MnemonicName::LWS;
 }
 
 constexpr auto is_store_type(sim::MnemonicName name) -> bool {
-    return name == sim::MnemonicName::SB || name == sim::MnemonicName::SH || name == sim::MnemonicName::SW;
+    return name == sim::MnemonicName::SB || name == sim::MnemonicName::SH || name == sim::MnemonicName::SW ||
+           name == sim::MnemonicName::SWS;
+}
+
+constexpr auto is_amo(sim::MnemonicName name) -> bool {
+    return name == sim::MnemonicName::AMOADD_W || name == sim::MnemonicName::AMOSWAP_W || name == sim::MnemonicName::AMOMIN_W ||
+           name == sim::MnemonicName::AMOMAX_W || name == sim::MnemonicName::AMOCAS_W;
+}
+
+constexpr auto is_reduction(sim::MnemonicName name) -> bool {
+    return name == sim::MnemonicName::SX_REDADD || name == sim::MnemonicName::SX_REDMIN || name == sim::MnemonicName::SX_REDMAX ||
+           name == sim::MnemonicName::SX_REDAND || name == sim::MnemonicName::SX_REDOR;
 }
 
 constexpr auto is_utype(sim::MnemonicName name) -> bool {
@@ -108,9 +128,16 @@ struct Instruction {
                                     to_string(operands.imm12);
                       }
                   },
-                  [&result](const parser::RtypeOperands &operands) {
-                      result += operands.rd.to_str() + ", " + operands.rs1.to_str() + ", " +
-                                operands.rs2.to_str();
+                  [&](const parser::RtypeOperands &operands) {
+                      if (is_amo(mnemonic.get_name())) {
+                          result += operands.rd.to_str() + ", " + operands.rs2.to_str() + ", (" +
+                                    operands.rs1.to_str() + ")";
+                      } else if (is_reduction(mnemonic.get_name())) {
+                          result += operands.rd.to_str() + ", " + operands.rs1.to_str();
+                      } else {
+                          result += operands.rd.to_str() + ", " + operands.rs1.to_str() + ", " +
+                                    operands.rs2.to_str();
+                      }
                   },
                   [&result](const parser::StypeOperands &operands) {
                       result += operands.rs2.to_str() + ", " + std::to_string(operands.imm12.value) + "(" +
@@ -135,6 +162,12 @@ struct Instruction {
                       const auto& immediate = std::get<token::Immediate>(operands.immediate_or_label_ref);
                       result += std::to_string(immediate.value) + "(" + operands.rs1.to_str() + ")";
                   },
+                  [&](const parser::MaskStackOperands &operands) {
+                      if (mnemonic.get_name() == sim::MnemonicName::SPLIT) {
+                          result += operands.rs1.to_str() + ", ";
+                      }
+                      result += to_string(operands.immediate_or_label_ref);
+                  },
 
                   /*[&result](const parser::UxtypeOperands &operands) {*/
                   /*    result += operands.rd.to_str() + ", " + std::to_string(operands.imm20);*/
@@ -198,10 +231,13 @@ class Parser {
     auto parse_itype_arithemtic_instruction(const sim::Mnemonic &mnemonic) -> std::optional<parser::Instruction>;
     auto parse_load_instruction(const sim::Mnemonic &mnemonic) -> std::optional<parser::Instruction>;
     auto parse_store_instruction(const sim::Mnemonic &mnemonic) -> std::optional<parser::Instruction>;
+    auto parse_amo_instruction(const sim::Mnemonic &mnemonic) -> std::optional<parser::Instruction>;
+    auto parse_reduction_instruction(const sim::Mnemonic &mnemonic) -> std::optional<parser::Instruction>;
     auto parse_branch_instruction(const sim::Mnemonic &mnemonic) -> std::optional<parser::Instruction>;
     auto parse_utype_instruction(const sim::Mnemonic &mnemonic) -> std::optional<parser::Instruction>;
     auto parse_jal_instruction(const sim::Mnemonic& mnemonic) -> std::optional<parser::Instruction>;
     auto parse_jalr_instruction(const sim::Mnemonic& mnemonic) -> std::optional<parser::Instruction>;
+    auto parse_mask_stack_instruction(const sim::Mnemonic& mnemonic) -> std::optional<parser::Instruction>;
 
     void push_err(Error &&err);
     void push_err(std::string &&message, unsigned column);
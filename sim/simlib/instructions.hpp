@@ -25,7 +25,19 @@ enum class Opcode : IData {
     // Custom opcodes (also only scalar)
     HALT     =  0b1111111,         // Used by HALT
     SX_SLT   =  0b1111110,         // Used by SX_SLT
-    SX_SLTI  =  0b1111101          // Used by SX_SLTI
+    SX_SLTI  =  0b1111101,         // Used by SX_SLTI
+    BAR      =  0b1111010,         // Used by BAR
+    SX_RED   =  0b1111001,         // Used by SX_REDADD, SX_REDMIN, SX_REDMAX, SX_REDAND, SX_REDOR (R-type without rs2)
+    SPLIT    =  0b1110110,         // Used by SPLIT (I-type without rd)
+    ELSE     =  0b1110101,         // Used by ELSE (I-type without rd and rs1)
+    JOIN     =  0b1110100,         // Used by JOIN
+    // Custom lane shuffle opcode (only vector, despite the MSB)
+    SHFL     =  0b1111000,         // Used by SHFL (R-type)
+    // Custom shared memory opcodes (only vector, despite the MSB)
+    LWS      =  0b1111100,         // Used by LWS (I-type)
+    SWS      =  0b1111011,         // Used by SWS (S-type)
+    // Atomic memory operations (only vector, the scalar opcode is JAL)
+    AMO      =  0b0101111          // Used by AMOADD.W, AMOSWAP.W, AMOMIN.W, AMOMAX.W, AMOCAS.W (R-type)
 };
 
 constexpr auto opcodes = std::array{
@@ -40,7 +52,16 @@ constexpr auto opcodes = std::array{
     Opcode::BTYPE,
     Opcode::HALT,
     Opcode::SX_SLT,
-    Opcode::SX_SLTI
+    Opcode::SX_SLTI,
+    Opcode::BAR,
+    Opcode::SX_RED,
+    Opcode::SPLIT,
+    Opcode::ELSE,
+    Opcode::JOIN,
+    Opcode::SHFL,
+    Opcode::LWS,
+    Opcode::SWS,
+    Opcode::AMO
 };
 
 constexpr auto is_of_type(IData opcode, Opcode type) -> bool {
@@ -132,6 +153,24 @@ constexpr auto str_to_opcode(std::string_view str) -> std::optional<IData> {
         opcode = (IData)Opcode::SX_SLT;
     } else if (str == "sx.slti") {
         opcode = (IData)Opcode::SX_SLTI;
+    } else if (str == "bar") {
+        opcode = (IData)Opcode::BAR;
+    } else if (str == "sx.redadd" || str == "sx.redmin" || str == "sx.redmax" || str == "sx.redand" || str == "sx.redor") {
+        opcode = (IData)Opcode::SX_RED;
+    } else if (str == "shfl") {
+        opcode = (IData)Opcode::SHFL;
+    } else if (str == "split") {
+        opcode = (IData)Opcode::SPLIT;
+    } else if (str == "else") {
+        opcode = (IData)Opcode::ELSE;
+    } else if (str == "join") {
+        opcode = (IData)Opcode::JOIN;
+    } else if (str == "lws") {
+        opcode = (IData)Opcode::LWS;
+    } else if (str == "sws") {
+        opcode = (IData)Opcode::SWS;
+    } else if (str == "amoadd.w" || str == "amoswap.w" || str == "amomin.w" || str == "amomax.w" || str == "amocas.w") {
+        opcode = (IData)Opcode::AMO;
     } else {
         return std::nullopt;
     }
@@ -169,6 +208,24 @@ constexpr auto opcode_to_str(IData opcode) -> std::string_view {
         return "sx.slt";
     case (IData)Opcode::SX_SLTI:
         return "sx.slti";
+    case (IData)Opcode::BAR:
+        return "bar";
+    case (IData)Opcode::SX_RED:
+        return "<sx.red>";
+    case (IData)Opcode::SHFL:
+        return "shfl";
+    case (IData)Opcode::SPLIT:
+        return "split";
+    case (IData)Opcode::ELSE:
+        return "else";
+    case (IData)Opcode::JOIN:
+        return "join";
+    case (IData)Opcode::LWS:
+        return "lws";
+    case (IData)Opcode::SWS:
+        return "sws";
+    case (IData)Opcode::AMO:
+        return "<amo>";
     default:
         return "unknown";
     }
@@ -198,6 +255,14 @@ enum class Funct3 : IData {
     SRA             = 0b101,
     OR              = 0b110,
     AND             = 0b111,
+// R-type multiply and divide
+    MUL             = 0b000,
+    MULH            = 0b001,
+    DIV             = 0b100,
+    REM             = 0b110,
+// R-type multiply-accumulate
+    MAC             = 0b000,
+    DOT4            = 0b001,
 // Load
     LB              = 0b000,
     LH              = 0b001,
@@ -213,6 +278,14 @@ enum class Funct3 : IData {
     BNE             = 0b001,
     BLT             = 0b100,
     BGE             = 0b101,
+// Atomic memory operations
+    AMO_W           = 0b010,
+// Warp reductions, the same as the matching R-type operations
+    REDADD          = 0b000,
+    REDMIN          = 0b100,
+    REDMAX          = 0b101,
+    REDOR           = 0b110,
+    REDAND          = 0b111,
 };
 
 constexpr auto funct3s = std::array{
@@ -233,6 +306,12 @@ constexpr auto funct3s = std::array{
     Funct3::SRA,
     Funct3::OR,
     Funct3::AND,
+    Funct3::MUL,
+    Funct3::MULH,
+    Funct3::DIV,
+    Funct3::REM,
+    Funct3::MAC,
+    Funct3::DOT4,
     Funct3::LB,
     Funct3::LH,
     Funct3::LW,
@@ -243,7 +322,13 @@ constexpr auto funct3s = std::array{
     Funct3::BEQ,
     Funct3::BNE,
     Funct3::BLT,
-    Funct3::BGE
+    Funct3::BGE,
+    Funct3::AMO_W,
+    Funct3::REDADD,
+    Funct3::REDMIN,
+    Funct3::REDMAX,
+    Funct3::REDOR,
+    Funct3::REDAND
 };
 
 // Funct7
@@ -262,6 +347,20 @@ enum class Funct7 : IData {
     SRA             = 0b0100000,
     OR              = 0b0000000,
     AND             = 0b0000000,
+// R-type multiply and divide
+    MUL             = 0b0000001,
+    MULH            = 0b0000001,
+    DIV             = 0b0000001,
+    REM             = 0b0000001,
+// R-type multiply-accumulate, rd is also the accumulator
+    MAC             = 0b0000101,
+    DOT4            = 0b0000101,
+// Atomic memory operations, funct5 followed by the (unused) aq and rl bits
+    AMOADD          = 0b0000000,
+    AMOSWAP         = 0b0000100,
+    AMOCAS          = 0b0010100,
+    AMOMIN          = 0b1000000,
+    AMOMAX          = 0b1010000,
 };
 
 constexpr auto funct7s = std::array{
@@ -276,7 +375,18 @@ constexpr auto funct7s = std::array{
     Funct7::SRL,
     Funct7::SRA,
     Funct7::OR,
-    Funct7::AND
+    Funct7::AND,
+    Funct7::MUL,
+    Funct7::MULH,
+    Funct7::DIV,
+    Funct7::REM,
+    Funct7::MAC,
+    Funct7::DOT4,
+    Funct7::AMOADD,
+    Funct7::AMOSWAP,
+    Funct7::AMOCAS,
+    Funct7::AMOMIN,
+    Funct7::AMOMAX
 };
 
 /*
@@ -452,6 +562,9 @@ constexpr auto create_btype_instruction(Opcode opcode, Funct3 funct3, Register r
     return InstructionBits{};
     /*return Instruction().set_opcode(opcode).set_funct3(funct3).set_rs1(rs1).set_rs2(rs2);*/
 }
+constexpr auto create_sx_red_instruction(Funct3 funct3, Register rd, Register rs1) -> InstructionBits {
+    return InstructionBits().set_opcode(Opcode::SX_RED).set_funct3(funct3).set_rd(rd).set_rs1(rs1);
+}
 constexpr auto create_stype_instruction(Opcode opcode, Funct3 funct3, Register rs1, Register rs2, IData imm12) -> InstructionBits {
     return InstructionBits().set_opcode(opcode).set_funct3(funct3).set_rs1(rs1).set_rs2(rs2).set_imm12(imm12);
 }
@@ -520,6 +633,26 @@ constexpr auto or_(Register rd, Register rs1, Register rs2) -> InstructionBits {
 constexpr auto and_(Register rd, Register rs1, Register rs2) -> InstructionBits {
     return create_rtype_instruction(Opcode::RTYPE, Funct3::AND, Funct7::AND, rd, rs1, rs2);
 }
+constexpr auto mul(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::RTYPE, Funct3::MUL, Funct7::MUL, rd, rs1, rs2);
+}
+constexpr auto mulh(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::RTYPE, Funct3::MULH, Funct7::MULH, rd, rs1, rs2);
+}
+constexpr auto div(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::RTYPE, Funct3::DIV, Funct7::DIV, rd, rs1, rs2);
+}
+constexpr auto rem(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::RTYPE, Funct3::REM, Funct7::REM, rd, rs1, rs2);
+}
+
+// Multiply-accumulate: rd = rd + rs1 * rs2, dot4 adds the products of the four signed bytes of rs1 and rs2 instead
+constexpr auto mac(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::RTYPE, Funct3::MAC, Funct7::MAC, rd, rs1, rs2);
+}
+constexpr auto dot4(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::RTYPE, Funct3::DOT4, Funct7::DOT4, rd, rs1, rs2);
+}
 
 // Load
 constexpr auto lb(Register rd, Register rs1, IData imm12) -> InstructionBits {
@@ -577,6 +710,68 @@ constexpr auto sx_slt(Register rd, Register rs1, Register rs2) -> InstructionBit
 constexpr auto sx_slti(Register rd, Register rs1, IData imm12) -> InstructionBits {
     return create_itype_instruction(Opcode::SX_SLTI, Funct3::SLTI, rd, rs1, imm12);
 }
+constexpr auto bar() -> InstructionBits {
+    return InstructionBits().set_opcode(Opcode::BAR);
+}
+
+// Warp reductions: rd = op(rs1[0], rs1[1], ...) over the active lanes, min and max are signed
+constexpr auto sx_redadd(Register rd, Register rs1) -> InstructionBits {
+    return create_sx_red_instruction(Funct3::REDADD, rd, rs1);
+}
+constexpr auto sx_redmin(Register rd, Register rs1) -> InstructionBits {
+    return create_sx_red_instruction(Funct3::REDMIN, rd, rs1);
+}
+constexpr auto sx_redmax(Register rd, Register rs1) -> InstructionBits {
+    return create_sx_red_instruction(Funct3::REDMAX, rd, rs1);
+}
+constexpr auto sx_redand(Register rd, Register rs1) -> InstructionBits {
+    return create_sx_red_instruction(Funct3::REDAND, rd, rs1);
+}
+constexpr auto sx_redor(Register rd, Register rs1) -> InstructionBits {
+    return create_sx_red_instruction(Funct3::REDOR, rd, rs1);
+}
+
+// Lane shuffle: rd[id] = rs1[rs2[id] % THREADS_PER_WARP]
+constexpr auto shfl(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::SHFL, {}, {}, rd, rs1, rs2);
+}
+
+// SIMT mask stack: split pushes s1 and narrows it to the lanes of rs1, else switches to the remaining lanes,
+// join restores the mask from before the split. split and else skip imm12 instructions if no lane is left
+constexpr auto split(Register rs1, IData imm12) -> InstructionBits {
+    return InstructionBits().set_opcode(Opcode::SPLIT).set_rs1(rs1).set_imm12(imm12);
+}
+constexpr auto else_(IData imm12) -> InstructionBits {
+    return InstructionBits().set_opcode(Opcode::ELSE).set_imm12(imm12);
+}
+constexpr auto join() -> InstructionBits {
+    return InstructionBits().set_opcode(Opcode::JOIN);
+}
+
+constexpr auto lws(Register rd, Register rs1, IData imm12) -> InstructionBits {
+    return create_itype_instruction(Opcode::LWS, Funct3::LW, rd, rs1, imm12);
+}
+constexpr auto sws(Register rs1, Register rs2, IData imm12) -> InstructionBits {
+    return create_stype_instruction(Opcode::SWS, Funct3::SW, rs1, rs2, imm12);
+}
+
+// Atomic memory operations: rd = mem[rs1], mem[rs1] = op(mem[rs1], rs2)
+// amocas_w only writes rs2 if mem[rs1] equals the previous value of rd
+constexpr auto amoadd_w(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::AMO, Funct3::AMO_W, Funct7::AMOADD, rd, rs1, rs2);
+}
+constexpr auto amoswap_w(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::AMO, Funct3::AMO_W, Funct7::AMOSWAP, rd, rs1, rs2);
+}
+constexpr auto amomin_w(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::AMO, Funct3::AMO_W, Funct7::AMOMIN, rd, rs1, rs2);
+}
+constexpr auto amomax_w(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::AMO, Funct3::AMO_W, Funct7::AMOMAX, rd, rs1, rs2);
+}
+constexpr auto amocas_w(Register rd, Register rs1, Register rs2) -> InstructionBits {
+    return create_rtype_instruction(Opcode::AMO, Funct3::AMO_W, Funct7::AMOCAS, rd, rs1, rs2);
+}
 }
 
 struct InstructionDeterminant {
@@ -608,6 +803,14 @@ enum class MnemonicName {
     SRA,
     OR,
     AND,
+    // R-type multiply and divide
+    MUL,
+    MULH,
+    DIV,
+    REM,
+    // R-type multiply-accumulate
+    MAC,
+    DOT4,
     // Load
     LB,
     LH,
@@ -629,7 +832,29 @@ enum class MnemonicName {
     HALT,
     // SX-type
     SX_SLT,
-    SX_SLTI
+    SX_SLTI,
+    // Barrier
+    BAR,
+    // Warp reductions and shuffle
+    SX_REDADD,
+    SX_REDMIN,
+    SX_REDMAX,
+    SX_REDAND,
+    SX_REDOR,
+    SHFL,
+    // Mask stack
+    SPLIT,
+    ELSE,
+    JOIN,
+    // Shared memory
+    LWS,
+    SWS,
+    // Atomic memory operations
+    AMOADD_W,
+    AMOSWAP_W,
+    AMOMIN_W,
+    AMOMAX_W,
+    AMOCAS_W
 };
 
 constexpr auto str_to_mnemonic_name(const std::string_view name) -> std::optional<MnemonicName> {
@@ -671,6 +896,18 @@ constexpr auto str_to_mnemonic_name(const std::string_view name) -> std::optiona
         return MnemonicName::OR;
     } else if (name == "and") {
         return MnemonicName::AND;
+    } else if (name == "mul") {
+        return MnemonicName::MUL;
+    } else if (name == "mulh") {
+        return MnemonicName::MULH;
+    } else if (name == "div") {
+        return MnemonicName::DIV;
+    } else if (name == "rem") {
+        return MnemonicName::REM;
+    } else if (name == "mac") {
+        return MnemonicName::MAC;
+    } else if (name == "dot4") {
+        return MnemonicName::DOT4;
     } else if (name == "lb") {
         return MnemonicName::LB;
     } else if (name == "lh") {
@@ -701,6 +938,40 @@ constexpr auto str_to_mnemonic_name(const std::string_view name) -> std::optiona
         return MnemonicName::SX_SLT;
     } else if (name == "sx.slti") {
         return MnemonicName::SX_SLTI;
+    } else if (name == "bar") {
+        return MnemonicName::BAR;
+    } else if (name == "sx.redadd") {
+        return MnemonicName::SX_REDADD;
+    } else if (name == "sx.redmin") {
+        return MnemonicName::SX_REDMIN;
+    } else if (name == "sx.redmax") {
+        return MnemonicName::SX_REDMAX;
+    } else if (name == "sx.redand") {
+        return MnemonicName::SX_REDAND;
+    } else if (name == "sx.redor") {
+        return MnemonicName::SX_REDOR;
+    } else if (name == "shfl") {
+        return MnemonicName::SHFL;
+    } else if (name == "split") {
+        return MnemonicName::SPLIT;
+    } else if (name == "else") {
+        return MnemonicName::ELSE;
+    } else if (name == "join") {
+        return MnemonicName::JOIN;
+    } else if (name == "lws") {
+        return MnemonicName::LWS;
+    } else if (name == "sws") {
+        return MnemonicName::SWS;
+    } else if (name == "amoadd.w") {
+        return MnemonicName::AMOADD_W;
+    } else if (name == "amoswap.w") {
+        return MnemonicName::AMOSWAP_W;
+    } else if (name == "amomin.w") {
+        return MnemonicName::AMOMIN_W;
+    } else if (name == "amomax.w") {
+        return MnemonicName::AMOMAX_W;
+    } else if (name == "amocas.w") {
+        return MnemonicName::AMOCAS_W;
     }
 
     return std::nullopt;
@@ -746,6 +1017,18 @@ constexpr auto to_string(const MnemonicName name) -> std::string_view {
         return "or";
     case MnemonicName::AND:
         return "and";
+    case MnemonicName::MUL:
+        return "mul";
+    case MnemonicName::MULH:
+        return "mulh";
+    case MnemonicName::DIV:
+        return "div";
+    case MnemonicName::REM:
+        return "rem";
+    case MnemonicName::MAC:
+        return "mac";
+    case MnemonicName::DOT4:
+        return "dot4";
     case MnemonicName::LB:
         return "lb";
     case MnemonicName::LH:
@@ -776,6 +1059,40 @@ constexpr auto to_string(const MnemonicName name) -> std::string_view {
         return "sx.slt";
     case MnemonicName::SX_SLTI:
         return "sx.slti";
+    case MnemonicName::BAR:
+        return "bar";
+    case MnemonicName::SX_REDADD:
+        return "sx.redadd";
+    case MnemonicName::SX_REDMIN:
+        return "sx.redmin";
+    case MnemonicName::SX_REDMAX:
+        return "sx.redmax";
+    case MnemonicName::SX_REDAND:
+        return "sx.redand";
+    case MnemonicName::SX_REDOR:
+        return "sx.redor";
+    case MnemonicName::SHFL:
+        return "shfl";
+    case MnemonicName::SPLIT:
+        return "split";
+    case MnemonicName::ELSE:
+        return "else";
+    case MnemonicName::JOIN:
+        return "join";
+    case MnemonicName::LWS:
+        return "lws";
+    case MnemonicName::SWS:
+        return "sws";
+    case MnemonicName::AMOADD_W:
+        return "amoadd.w";
+    case MnemonicName::AMOSWAP_W:
+        return "amoswap.w";
+    case MnemonicName::AMOMIN_W:
+        return "amomin.w";
+    case MnemonicName::AMOMAX_W:
+        return "amomax.w";
+    case MnemonicName::AMOCAS_W:
+        return "amocas.w";
     }
 
     return "unknown";
@@ -821,6 +1138,13 @@ constexpr auto mnemonic_name_to_opcode(MnemonicName name) -> Opcode {
         return Opcode::RTYPE;
     case MnemonicName::AND:
         return Opcode::RTYPE;
+    case MnemonicName::MUL:
+    case MnemonicName::MULH:
+    case MnemonicName::DIV:
+    case MnemonicName::REM:
+    case MnemonicName::MAC:
+    case MnemonicName::DOT4:
+        return Opcode::RTYPE;
     case MnemonicName::LB:
         return Opcode::LOAD;
     case MnemonicName::LH:
@@ -851,6 +1175,32 @@ constexpr auto mnemonic_name_to_opcode(MnemonicName name) -> Opcode {
         return Opcode::SX_SLT;
     case MnemonicName::SX_SLTI:
         return Opcode::SX_SLTI;
+    case MnemonicName::BAR:
+        return Opcode::BAR;
+    case MnemonicName::SX_REDADD:
+    case MnemonicName::SX_REDMIN:
+    case MnemonicName::SX_REDMAX:
+    case MnemonicName::SX_REDAND:
+    case MnemonicName::SX_REDOR:
+        return Opcode::SX_RED;
+    case MnemonicName::SHFL:
+        return Opcode::SHFL;
+    case MnemonicName::SPLIT:
+        return Opcode::SPLIT;
+    case MnemonicName::ELSE:
+        return Opcode::ELSE;
+    case MnemonicName::JOIN:
+        return Opcode::JOIN;
+    case MnemonicName::LWS:
+        return Opcode::LWS;
+    case MnemonicName::SWS:
+        return Opcode::SWS;
+    case MnemonicName::AMOADD_W:
+    case MnemonicName::AMOSWAP_W:
+    case MnemonicName::AMOMIN_W:
+    case MnemonicName::AMOMAX_W:
+    case MnemonicName::AMOCAS_W:
+        return Opcode::AMO;
     }
 }
 
@@ -874,7 +1224,9 @@ struct Mnemonic {
     }
 
     [[nodiscard]] auto is_vector_scalar() const -> bool {
-        return name == MnemonicName::SX_SLT || name == MnemonicName::SX_SLTI;
+        return name == MnemonicName::SX_SLT || name == MnemonicName::SX_SLTI || name == MnemonicName::SX_REDADD ||
+               name == MnemonicName::SX_REDMIN || name == MnemonicName::SX_REDMAX || name == MnemonicName::SX_REDAND ||
+               name == MnemonicName::SX_REDOR;
     }
 
     [[nodiscard]] auto is_branch() const -> bool {
@@ -885,9 +1237,13 @@ struct Mnemonic {
         return name == MnemonicName::JAL || name == MnemonicName::JALR;
     }
 
+    [[nodiscard]] auto is_mask_stack() const -> bool {
+        return name == MnemonicName::SPLIT || name == MnemonicName::ELSE || name == MnemonicName::JOIN;
+    }
+
     // in practice, that is equivalent to MSB of the opcode being 1
     [[nodiscard]] auto is_scalar() const -> bool {
-        return has_s_prefix || is_vector_scalar() || is_branch() || is_jump();
+        return has_s_prefix || is_vector_scalar() || is_branch() || is_jump() || is_mask_stack();
     }
 
     auto operator==(const Mnemonic &other) const -> bool {
@@ -957,6 +1313,20 @@ constexpr auto name_to_determinant(MnemonicName name) -> InstructionDeterminant
             return {Opcode::RTYPE, Funct3::OR, Funct7::OR};
         case MnemonicName::AND:
             return {Opcode::RTYPE, Funct3::AND, Funct7::AND};
+        // R-type multiply and divide
+        case MnemonicName::MUL:
+            return {Opcode::RTYPE, Funct3::MUL, Funct7::MUL};
+        case MnemonicName::MULH:
+            return {Opcode::RTYPE, Funct3::MULH, Funct7::MULH};
+        case MnemonicName::DIV:
+            return {Opcode::RTYPE, Funct3::DIV, Funct7::DIV};
+        case MnemonicName::REM:
+            return {Opcode::RTYPE, Funct3::REM, Funct7::REM};
+        // R-type multiply-accumulate
+        case MnemonicName::MAC:
+            return {Opcode::RTYPE, Funct3::MAC, Funct7::MAC};
+        case MnemonicName::DOT4:
+            return {Opcode::RTYPE, Funct3::DOT4, Funct7::DOT4};
         // Load
         case MnemonicName::LB:
             return {Opcode::LOAD, Funct3::LB, {}};
@@ -994,6 +1364,45 @@ constexpr auto name_to_determinant(MnemonicName name) -> InstructionDeterminant
             return {Opcode::SX_SLT, Funct3::SLT, Funct7::SLT};
         case MnemonicName::SX_SLTI:
             return {Opcode::SX_SLTI, Funct3::SLTI, {}};
+        // Barrier
+        case MnemonicName::BAR:
+            return {Opcode::BAR, {}, {}};
+        // Warp reductions and shuffle
+        case MnemonicName::SX_REDADD:
+            return {Opcode::SX_RED, Funct3::REDADD, {}};
+        case MnemonicName::SX_REDMIN:
+            return {Opcode::SX_RED, Funct3::REDMIN, {}};
+        case MnemonicName::SX_REDMAX:
+            return {Opcode::SX_RED, Funct3::REDMAX, {}};
+        case MnemonicName::SX_REDAND:
+            return {Opcode::SX_RED, Funct3::REDAND, {}};
+        case MnemonicName::SX_REDOR:
+            return {Opcode::SX_RED, Funct3::REDOR, {}};
+        case MnemonicName::SHFL:
+            return {Opcode::SHFL, {}, {}};
+        // Mask stack
+        case MnemonicName::SPLIT:
+            return {Opcode::SPLIT, {}, {}};
+        case MnemonicName::ELSE:
+            return {Opcode::ELSE, {}, {}};
+        case MnemonicName::JOIN:
+            return {Opcode::JOIN, {}, {}};
+        // Shared memory
+        case MnemonicName::LWS:
+            return {Opcode::LWS, Funct3::LW, {}};
+        case MnemonicName::SWS:
+            return {Opcode::SWS, Funct3::SW, {}};
+        // Atomic memory operations
+        case MnemonicName::AMOADD_W:
+            return {Opcode::AMO, Funct3::AMO_W, Funct7::AMOADD};
+        case MnemonicName::AMOSWAP_W:
+            return {Opcode::AMO, Funct3::AMO_W, Funct7::AMOSWAP};
+        case MnemonicName::AMOMIN_W:
+            return {Opcode::AMO, Funct3::AMO_W, Funct7::AMOMIN};
+        case MnemonicName::AMOMAX_W:
+            return {Opcode::AMO, Funct3::AMO_W, Funct7::AMOMAX};
+        case MnemonicName::AMOCAS_W:
+            return {Opcode::AMO, Funct3::AMO_W, Funct7::AMOCAS};
     }
 
     std::unreachable();
@@ -1,12 +1,18 @@
 #pragma once
 #include <print>
 #include <array>
+#include <algorithm>
+#include <optional>
+#include <vector>
 #include "Vgpu.h"
 #include "instructions.hpp"
 
 namespace sim {
 
-constexpr void tick(Vgpu& top) {
+// The harness is templated on the verilated model, so that the same memory models can drive
+// GPU variants verilated with different parameters (see the benchmarks)
+template <typename Gpu>
+constexpr void tick(Gpu& top) {
     top.clk = 0;
     top.eval();
     top.clk = 1;
@@ -26,34 +32,92 @@ constexpr bool get_bit(CData signal, int bit) {
     return (signal >> bit) & 1;
 }
 
+// The memory controllers send at most one tagged request per channel per cycle and expect a single
+// tagged response per channel per cycle, in any order
+struct PendingResponse {
+    uint64_t ready_cycle;
+    SData tag;
+    IData data;
+};
+
 template <uint32_t num_channels>
+struct ResponseQueue {
+    std::array<std::vector<PendingResponse>, num_channels> pending{};
+
+    void push(size_t channel, PendingResponse response) {
+        pending[channel].push_back(response);
+    }
+
+    // Removes the response that became ready first on this channel, if any
+    auto pop(size_t channel, uint64_t cycle) -> std::optional<PendingResponse> {
+        auto& queue = pending[channel];
+        auto earliest = queue.end();
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (it->ready_cycle <= cycle && (earliest == queue.end() || it->ready_cycle < earliest->ready_cycle)) {
+                earliest = it;
+            }
+        }
+        if (earliest == queue.end()) {
+            return std::nullopt;
+        }
+        auto response = *earliest;
+        queue.erase(earliest);
+        return response;
+    }
+};
+
+// Cycles a request takes to be answered: a fixed latency, plus a deterministic per-address jitter
+// so that requests on the same channel can complete out of order
+constexpr uint64_t response_latency(IData addr, uint32_t latency, uint32_t latency_jitter) {
+    if (latency_jitter == 0) {
+        return latency;
+    }
+    return latency + (addr * 2654435761u >> 16) % (latency_jitter + 1);
+}
+
+template <uint32_t num_channels, typename Gpu = Vgpu>
 struct InstructionMemory {
     static constexpr IData MAX_SIZE = std::numeric_limits<IData>::max();
 
-    Vgpu* dut;
-    CData *instruction_mem_read_valid;                              // input
-    std::array<IData*, num_channels> instruction_mem_read_address;  // input
-    CData *instruction_mem_read_ready;                              // output
-    std::array<IData*, num_channels> instruction_mem_read_data;     // output
+    Gpu* dut;
+    CData *instruction_mem_read_valid;                                      // input
+    std::array<IData*, num_channels> instruction_mem_read_address;          // input
+    std::array<SData*, num_channels> instruction_mem_read_tag;              // input
+    CData *instruction_mem_read_ready;                                      // output
+    std::array<IData*, num_channels> instruction_mem_read_data;             // output
+    std::array<SData*, num_channels> instruction_mem_read_response_tag;     // output
 
     std::unordered_map<IData, IData> memory{};
 
-    // Process read requests
+    // Latency model, zero latency answers requests in the cycle they are sent
+    uint32_t latency = 0;
+    uint32_t latency_jitter = 0;
+    uint64_t cycle = 0;
+    ResponseQueue<num_channels> read_responses{};
+
+    // Accept new read requests and send back the responses that are ready
     void process() {
         for (size_t i = 0; i < num_channels; i++) {
             if (*instruction_mem_read_valid & (1 << i)) {
                 IData addr = *instruction_mem_read_address[i];
+                IData data = 0;
                 if (addr < MAX_SIZE) {
-                    *instruction_mem_read_data[i] = memory[addr];
+                    data = memory[addr];
                 } else {
-                    *instruction_mem_read_data[i] = 0;
                     std::println(stderr, "Error: Read out of bounds {}", addr);
                 }
+                read_responses.push(i, {cycle + response_latency(addr, latency, latency_jitter), *instruction_mem_read_tag[i], data});
+            }
+
+            if (auto response = read_responses.pop(i, cycle)) {
+                *instruction_mem_read_data[i] = response->data;
+                *instruction_mem_read_response_tag[i] = response->tag;
                 set_bit(*instruction_mem_read_ready, (int)i, true);
             } else {
                 set_bit(*instruction_mem_read_ready, (int)i, false);
             }
         }
+        cycle++;
     }
 
     // Method to load an instruction into memory
@@ -77,28 +141,94 @@ struct InstructionMemory {
 };
 
 
+// Read-modify-write operation carried by a data memory read, matches atomic_op_t in common.sv
+enum class AtomicOp : CData {
+    NONE,
+    ADD,
+    SWAP,
+    MIN,
+    MAX,
+    CAS,
+};
+
+// New value of a word updated by an atomic, min and max compare signed values
+constexpr auto apply_atomic(AtomicOp op, IData old_value, IData operand, IData compare) -> IData {
+    switch (op) {
+    case AtomicOp::ADD:
+        return old_value + operand;
+    case AtomicOp::SWAP:
+        return operand;
+    case AtomicOp::MIN:
+        return (int32_t)operand < (int32_t)old_value ? operand : old_value;
+    case AtomicOp::MAX:
+        return (int32_t)operand > (int32_t)old_value ? operand : old_value;
+    case AtomicOp::CAS:
+        return old_value == compare ? operand : old_value;
+    default:
+        return old_value;
+    }
+}
+
 using data_memory_container_t = std::map<IData, IData>;
-template <uint32_t num_channels>
+template <uint32_t num_channels, typename Gpu = Vgpu>
 struct DataMemory {
     static constexpr IData MAX_SIZE = std::numeric_limits<IData>::max();
 
-    Vgpu* dut;
-    CData *data_mem_read_valid;                  // input
-    IData *data_mem_read_address[num_channels];  // input
-    CData *data_mem_read_ready;                  // output
-    IData *data_mem_read_data[num_channels];     // output
-    CData *data_mem_write_valid;                 // input
-    IData *data_mem_write_address[num_channels]; // input
-    IData *data_mem_write_data[num_channels];    // input
-    CData *data_mem_write_ready;                 // output
+    Gpu* dut;
+    CData *data_mem_read_valid;                         // input
+    IData *data_mem_read_address[num_channels];         // input
+    SData *data_mem_read_tag[num_channels];             // input
+    CData *data_mem_read_atomic_op[num_channels];       // input
+    IData *data_mem_read_atomic_operand[num_channels];  // input
+    IData *data_mem_read_atomic_compare[num_channels];  // input
+    CData *data_mem_read_ready;                         // output
+    IData *data_mem_read_data[num_channels];            // output
+    SData *data_mem_read_response_tag[num_channels];    // output
+    CData *data_mem_write_valid;                        // input
+    IData *data_mem_write_address[num_channels];        // input
+    IData *data_mem_write_data[num_channels];           // input
+    SData *data_mem_write_tag[num_channels];            // input
+    CData *data_mem_write_ready;                        // output
+    SData *data_mem_write_response_tag[num_channels];   // output
 
     data_memory_container_t memory{};
 
+    // Latency model, zero latency answers requests in the cycle they are sent
+    uint32_t latency = 0;
+    uint32_t latency_jitter = 0;
+    uint64_t cycle = 0;
+    ResponseQueue<num_channels> read_responses{};
+    ResponseQueue<num_channels> write_responses{};
+
+    // Banked memory model, disabled when bank_busy_cycles is zero
+    // Blocks of 2^bank_interleave_shift words are spread over num_channels banks, like the interleaved
+    // channel mapping of the data memory controller. A bank starts one request every bank_busy_cycles,
+    // so requests to the same bank queue up behind each other
+    uint32_t bank_busy_cycles = 0;
+    uint32_t bank_interleave_shift = 2;
+    std::array<uint64_t, num_channels> bank_free_cycle{};
+    uint64_t bank_conflict_cycles = 0; // Cycles requests spent waiting for a busy bank
+
+    // Cycle at which the response to a request that arrives now becomes ready
+    auto response_cycle(IData addr) -> uint64_t {
+        auto start = cycle;
+        if (bank_busy_cycles != 0) {
+            auto& bank_free = bank_free_cycle[(addr >> bank_interleave_shift) % num_channels];
+            start = std::max(cycle, bank_free);
+            bank_conflict_cycles += start - cycle;
+            bank_free = start + bank_busy_cycles;
+        }
+        return start + response_latency(addr, latency, latency_jitter);
+    }
+
     auto operator[](IData addr) -> IData& {
         return memory[addr];
     }
 
     // Process read and write requests
+    // Writes are applied when they arrive and reads return the value at the time they arrive,
+    // only the responses are delayed by the latency model
+    // Atomics are reads that also write the updated word when they arrive, so they are a single transaction
     void process() {
         // Process writes first
         for (size_t i = 0; i < num_channels; i++) {
@@ -109,6 +239,11 @@ struct DataMemory {
                 } else {
                     std::println(stderr, "Error: Write to invalid address {}", addr);
                 }
+                write_responses.push(i, {response_cycle(addr), *data_mem_write_tag[i], 0});
+            }
+
+            if (auto response = write_responses.pop(i, cycle)) {
+                *data_mem_write_response_tag[i] = response->tag;
                 set_bit(*data_mem_write_ready, (int)i, true);
             } else {
                 set_bit(*data_mem_write_ready, (int)i, false);
@@ -119,17 +254,28 @@ struct DataMemory {
         for (size_t i = 0; i < num_channels; i++) {
             if (*data_mem_read_valid & (1 << i)) {
                 IData addr = *data_mem_read_address[i];
+                IData data = 0;
                 if (addr < MAX_SIZE) {
-                    *data_mem_read_data[i] = memory[addr];
+                    data = memory[addr];
+                    auto op = (AtomicOp)*data_mem_read_atomic_op[i];
+                    if (op != AtomicOp::NONE) {
+                        memory[addr] = apply_atomic(op, data, *data_mem_read_atomic_operand[i], *data_mem_read_atomic_compare[i]);
+                    }
                 } else {
-                    data_mem_read_data[i] = 0;
                     std::println(stderr, "Error: Read from invalid address {}", addr);
                 }
+                read_responses.push(i, {response_cycle(addr), *data_mem_read_tag[i], data});
+            }
+
+            if (auto response = read_responses.pop(i, cycle)) {
+                *data_mem_read_data[i] = response->data;
+                *data_mem_read_response_tag[i] = response->tag;
                 set_bit(*data_mem_read_ready, (int)i, true);
             } else {
                 set_bit(*data_mem_read_ready, (int)i, false);
             }
         }
+        cycle++;
     }
 
     // Optional: Method to print memory content for debugging
@@ -151,22 +297,24 @@ struct DataMemory {
     uint32_t stack_ptr = 0u;
 };
 
-template <uint32_t num_channels>
-auto make_instruction_memory(Vgpu* dut) -> InstructionMemory<num_channels> {
-    InstructionMemory<num_channels> mem{};
+template <uint32_t num_channels, typename Gpu>
+auto make_instruction_memory(Gpu* dut) -> InstructionMemory<num_channels, Gpu> {
+    InstructionMemory<num_channels, Gpu> mem{};
     mem.dut = dut;
     mem.instruction_mem_read_valid = &dut->instruction_mem_read_valid;
     mem.instruction_mem_read_ready = &dut->instruction_mem_read_ready;
     for (auto i = 0u; i < num_channels; i++) {
         mem.instruction_mem_read_address[i] = &dut->instruction_mem_read_address[i];
+        mem.instruction_mem_read_tag[i] = &dut->instruction_mem_read_tag[i];
         mem.instruction_mem_read_data[i] = &dut->instruction_mem_read_data[i];
+        mem.instruction_mem_read_response_tag[i] = &dut->instruction_mem_read_response_tag[i];
     }
     return mem;
 }
 
-template <uint32_t num_channels>
-auto make_data_memory(Vgpu* dut) -> DataMemory<num_channels> {
-    DataMemory<num_channels> mem{};
+template <uint32_t num_channels, typename Gpu>
+auto make_data_memory(Gpu* dut) -> DataMemory<num_channels, Gpu> {
+    DataMemory<num_channels, Gpu> mem{};
     mem.dut = dut;
     mem.data_mem_read_valid = &dut->data_mem_read_valid;
     mem.data_mem_read_ready = &dut->data_mem_read_ready;
@@ -174,14 +322,22 @@ auto make_data_memory(Vgpu* dut) -> DataMemory<num_channels> {
     mem.data_mem_write_ready = &dut->data_mem_write_ready;
     for (auto i = 0u; i < num_channels; i++) {
         mem.data_mem_read_address[i] = &dut->data_mem_read_address[i];
+        mem.data_mem_read_tag[i] = &dut->data_mem_read_tag[i];
+        mem.data_mem_read_atomic_op[i] = &dut->data_mem_read_atomic_op[i];
+        mem.data_mem_read_atomic_operand[i] = &dut->data_mem_read_atomic_operand[i];
+        mem.data_mem_read_atomic_compare[i] = &dut->data_mem_read_atomic_compare[i];
         mem.data_mem_read_data[i] = &dut->data_mem_read_data[i];
+        mem.data_mem_read_response_tag[i] = &dut->data_mem_read_response_tag[i];
         mem.data_mem_write_address[i] = &dut->data_mem_write_address[i];
         mem.data_mem_write_data[i] = &dut->data_mem_write_data[i];
+        mem.data_mem_write_tag[i] = &dut->data_mem_write_tag[i];
+        mem.data_mem_write_response_tag[i] = &dut->data_mem_write_response_tag[i];
     }
     return mem;
 }
 
-constexpr void set_kernel_config(Vgpu& top, IData base_instructions_address, IData base_data_address, IData num_blocks, IData num_warps_per_block) {
+template <typename Gpu>
+constexpr void set_kernel_config(Gpu& top, IData base_instructions_address, IData base_data_address, IData num_blocks, IData num_warps_per_block) {
     VlWide<4>& kernel_config = top.kernel_config;
     kernel_config[3] = base_instructions_address;
     kernel_config[2] = base_data_address;
@@ -189,15 +345,16 @@ constexpr void set_kernel_config(Vgpu& top, IData base_instructions_address, IDa
     kernel_config[0] = num_warps_per_block;
 }
 
-template <uint32_t num_channels>
-bool simulate(Vgpu& top, InstructionMemory<num_channels>& instruction_mem, DataMemory<num_channels>& data_mem, uint32_t max_num_cycles) {
+// Returns the number of cycles the kernel took, or nothing if it did not finish in time
+template <uint32_t num_channels, typename Gpu>
+auto simulate_cycles(Gpu& top, InstructionMemory<num_channels, Gpu>& instruction_mem, DataMemory<num_channels, Gpu>& data_mem, uint32_t max_num_cycles) -> std::optional<uint32_t> {
     top.execution_start = 1;
 
     for (auto cycle = 0u; cycle < max_num_cycles; ++cycle) {
         top.eval();
 
         if (top.execution_done) {
-            return true;
+            return cycle;
         }
 
         instruction_mem.process();
@@ -207,7 +364,12 @@ bool simulate(Vgpu& top, InstructionMemory<num_channels>& instruction_mem, DataM
 
         tick(top);
     }
-    return false;
+    return std::nullopt;
+}
+
+template <uint32_t num_channels, typename Gpu>
+bool simulate(Gpu& top, InstructionMemory<num_channels, Gpu>& instruction_mem, DataMemory<num_channels, Gpu>& data_mem, uint32_t max_num_cycles) {
+    return simulate_cycles(top, instruction_mem, data_mem, max_num_cycles).has_value();
 }
 
 } // namespace sim
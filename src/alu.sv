@@ -12,11 +12,42 @@ module alu (
     input data_t imm,
     input data_t rs1,
     input data_t rs2,
+    input data_t rs3,                   // Accumulator of MAC and DOT4
     input alu_instruction_t instruction,
 
     output data_t alu_out
 );
 
+// The multiplier and divider are not pipelined. The core models their latency by counting MUL_LATENCY or DIV_LATENCY
+// cycles with the warp in WARP_WAIT, the operands stay in rs1, rs2 and rs3 meanwhile and no other instruction uses the ALUs
+data_t mul_result;
+data_t div_result;
+
+// Signed, division by zero and overflow give the same results as in RISC-V
+always_comb begin
+    logic signed [2*`DATA_WIDTH-1:0] product;
+    logic signed [`DATA_WIDTH-1:0] dot;
+    product = (2*`DATA_WIDTH)'($signed(rs1)) * (2*`DATA_WIDTH)'($signed(rs2));
+    dot = 0;
+    for (int i = 0; i < `DATA_WIDTH / 8; i = i + 1) begin
+        dot = dot + $signed(rs1[8*i +: 8]) * $signed(rs2[8*i +: 8]);
+    end
+    case (instruction)
+        MULH: mul_result = product[2*`DATA_WIDTH-1:`DATA_WIDTH];
+        MAC: mul_result = rs3 + product[`DATA_WIDTH-1:0];
+        DOT4: mul_result = rs3 + dot;
+        default: mul_result = product[`DATA_WIDTH-1:0];
+    endcase
+
+    if (rs2 == 0) begin
+        div_result = instruction == REM ? rs1 : {`DATA_WIDTH{1'b1}};
+    end else if (rs1 == {1'b1, {(`DATA_WIDTH-1){1'b0}}} && rs2 == {`DATA_WIDTH{1'b1}}) begin
+        div_result = instruction == REM ? {`DATA_WIDTH{1'b0}} : rs1;
+    end else begin
+        div_result = instruction == REM ? data_t'($signed(rs1) % $signed(rs2)) : data_t'($signed(rs1) / $signed(rs2));
+    end
+end
+
 always @(posedge clk) begin
     if (reset) begin
         alu_out <= 0;
@@ -73,6 +104,12 @@ always @(posedge clk) begin
             AND: begin
                 alu_out <= rs1 & rs2;
             end
+            MUL, MULH, MAC, DOT4: begin
+                alu_out <= mul_result;
+            end
+            DIV, REM: begin
+                alu_out <= div_result;
+            end
             BEQ: begin
                 alu_out <= (rs1 == rs2) ? 1 : 0;
             end
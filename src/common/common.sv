@@ -13,6 +13,7 @@ typedef logic [`DATA_WIDTH-1:0] data_t;
 typedef logic [`INSTRUCTION_WIDTH-1:0] instruction_t;
 typedef logic [`DATA_MEMORY_ADDRESS_WIDTH-1:0] data_memory_address_t;
 typedef logic [`INSTRUCTION_MEMORY_ADDRESS_WIDTH-1:0] instruction_memory_address_t;
+typedef logic [15:0] mem_tag_t; // Identifies the consumer a memory request belongs to, echoed back with the response
 
 typedef struct packed {
     instruction_memory_address_t base_instructions_address;
@@ -21,6 +22,20 @@ typedef struct packed {
     data_t num_warps_per_block;
 } kernel_config_t;
 
+// Memory Controller Arbitration Policies
+`define ARBITRATION_ROUND_ROBIN 0    // Rotate priority over all consumers
+`define ARBITRATION_AGE_BASED   1    // Serve the consumer that has been waiting the longest
+`define ARBITRATION_FAIR_SHARE  2    // Rotate over consumer groups (cores), then round-robin within the group
+
+// Memory Controller Channel Mappings
+`define CHANNEL_MAPPING_ANY         0   // Any idle channel picks up any pending request
+`define CHANNEL_MAPPING_INTERLEAVED 1   // The channel is selected by address bits, one queue per channel
+
+// Warp Scheduling Policies
+`define SCHEDULER_LOOSE_ROUND_ROBIN  0  // Rotate over the ready warps, starting after the current one
+`define SCHEDULER_GREEDY_THEN_OLDEST 1  // Keep the current warp until it stalls, then pick the oldest ready warp
+`define SCHEDULER_TWO_LEVEL          2  // Round-robin over a small active set, warps stalled on memory are swapped out
+
 // RISC-V Definitions
 `define OPCODE_WIDTH 7
 `define FUNCT3_WIDTH 3
@@ -34,9 +49,50 @@ typedef struct packed {
 `define OPCODE_SX_SLT   7'b1111110        // SX_SLT rd, rs1, rs2 <=> rd[id] = rs1 < rs2 ? 1 : 0
 `define OPCODE_SX_SLTI  7'b1111101        // SX_SLTI rd, rs1, imm <=> rd[id] = rs1 < imm ? 1 : 0
 
+// Warp-Level Instruction Opcodes (SX_RED and SHFL)
+// SX_RED combines rs1 of the active lanes into a scalar register, funct3 selects the operation (like the R-type ALU
+// operations, MIN and MAX are signed). SHFL is a vector instruction despite its opcode
+`define OPCODE_SX_RED   7'b1111001        // SX_REDADD rd, rs1 <=> rd = rs1[0] + rs1[1] + ... (active lanes only)
+`define OPCODE_SHFL     7'b1111000        // SHFL rd, rs1, rs2 <=> rd[id] = rs1[rs2[id] % THREADS_PER_WARP]
+`define FUNCT3_REDADD   3'b000
+`define FUNCT3_REDMIN   3'b100
+`define FUNCT3_REDMAX   3'b101
+`define FUNCT3_REDOR    3'b110
+`define FUNCT3_REDAND   3'b111
+
+// SIMT Mask Stack Instruction Opcodes (SPLIT, ELSE and JOIN)
+// Each warp keeps a stack of execution masks, so divergent regions need no mask bookkeeping in software
+// A path that no lane takes is skipped by jumping imm instructions ahead
+`define OPCODE_SPLIT    7'b1110110        // SPLIT rs1, imm <=> push {s1, s1 & ~rs1}, s1 = s1 & rs1, pc += imm if s1 == 0
+`define OPCODE_ELSE     7'b1110101        // ELSE imm <=> s1 = second mask on top of the stack, pc += imm if s1 == 0
+`define OPCODE_JOIN     7'b1110100        // JOIN <=> s1 = first mask on top of the stack, pop
+
+// Barrier Instruction Opcode
+// BAR holds the warp until every warp of its block that has not halted reached a BAR as well
+`define OPCODE_BAR      7'b1111010
+
+// Shared Memory Instruction Opcodes (LWS and SWS)
+// Vector loads and stores that access the scratchpad of the core instead of the data memory, addresses are word indices
+`define OPCODE_LWS      7'b1111100        // LWS rd, imm(rs1) <=> rd = shared[rs1 + imm]
+`define OPCODE_SWS      7'b1111011        // SWS rs2, imm(rs1) <=> shared[rs1 + imm] = rs2
+
+// Atomic Memory Operation Opcode (AMOADD.W, AMOSWAP.W, AMOMIN.W, AMOMAX.W, AMOCAS.W)
+// AMO rd, rs2, (rs1) <=> rd = mem[rs1], mem[rs1] = op(mem[rs1], rs2), performed by data memory as a single transaction
+// funct5 (instruction[31:27]) selects the operation. AMOs are vector instructions only, the scalar opcode is JAL
+`define OPCODE_AMO      7'b0101111
+`define FUNCT5_AMOADD   5'b00000
+`define FUNCT5_AMOSWAP  5'b00001
+`define FUNCT5_AMOCAS   5'b00101          // Only writes rs2 if mem[rs1] equals the previous value of rd
+`define FUNCT5_AMOMIN   5'b10000          // Signed
+`define FUNCT5_AMOMAX   5'b10100          // Signed
+
 // Instruction Opcodes
 // The entire opcode is 7 bits, the most significant bit decides whether the instruction is vector or scalar
-`define OPCODE_R        6'b110011         // Used by all R-type instructions (ADD, SUB, SLL, SLT, XOR, SRL, SRA)
+`define OPCODE_R        6'b110011         // Used by all R-type instructions (ADD, SUB, SLL, SLT, XOR, SRL, SRA, MUL, MULH, DIV, REM, MAC, DOT4)
+`define FUNCT7_MULDIV   7'b0000001        // Selects the multiply and divide instructions within OPCODE_R, as in RV32M
+`define FUNCT7_MAC      7'b0000101        // Selects the multiply-accumulate instructions within OPCODE_R, rd is also read as the third source
+`define FUNCT3_MAC      3'b000            // MAC rd, rs1, rs2 <=> rd = rd + rs1 * rs2
+`define FUNCT3_DOT4     3'b001            // DOT4 rd, rs1, rs2 <=> rd = rd + rs1[7:0] * rs2[7:0] + ... + rs1[31:24] * rs2[31:24] (signed bytes)
 `define OPCODE_I        6'b010011         // Used by ALU I-type instructions (ADDI, SLTI, XORI, ORI, ANDI, SLLI, SRLI, SRAI)
 `define OPCODE_S        6'b100011         // Used by store instructions (SB, SH, SW)
 `define OPCODE_U        6'b110111         // Used by LUI
@@ -54,7 +110,7 @@ typedef logic [`FUNCT7_WIDTH-1:0] funct7_t;
 typedef logic [11:0] imm12_t;
 
 // alu instructions enum
-typedef enum logic [4:0] {
+typedef enum logic [5:0] {
     // immediate instructions
     ADDI,
     SLTI,
@@ -76,6 +132,16 @@ typedef enum logic [4:0] {
     OR,
     AND,
 
+    // multiply and divide instructions (signed), these take MUL_LATENCY and DIV_LATENCY cycles
+    MUL,
+    MULH,
+    DIV,
+    REM,
+
+    // multiply-accumulate instructions, these add to the third source and take MUL_LATENCY cycles
+    MAC,
+    DOT4,
+
     // compare instructions
     BEQ,
     BNE,
@@ -91,12 +157,12 @@ typedef enum logic [4:0] {
 typedef enum logic [2:0] {
     WARP_IDLE,
     WARP_FETCH,
-    WARP_DECODE,
     WARP_REQUEST,
     WARP_WAIT,
     WARP_EXECUTE,
     WARP_UPDATE,
-    WARP_DONE
+    WARP_DONE,
+    WARP_BARRIER
 } warp_state_t;
 
 // fetcher state enum
@@ -114,13 +180,58 @@ typedef enum logic [1:0] {
     LSU_DONE
 } lsu_state_t;
 
+// cache memory port state enum
+typedef enum logic [1:0] {
+    PORT_IDLE,
+    PORT_REQUESTING,
+    PORT_RELEASING
+} cache_port_state_t;
+
+// data cache mshr state enum
+typedef enum logic [1:0] {
+    MSHR_IDLE,
+    MSHR_WRITEBACK,
+    MSHR_FILL
+} mshr_state_t;
+
+// atomic memory operation enum, sent along with a data memory read (ATOMIC_NONE for plain loads)
+typedef enum logic [2:0] {
+    ATOMIC_NONE,
+    ATOMIC_ADD,
+    ATOMIC_SWAP,
+    ATOMIC_MIN,
+    ATOMIC_MAX,
+    ATOMIC_CAS
+} atomic_op_t;
+
+// cross-lane operation enum, for the instructions that read the operands of other lanes of the warp
+typedef enum logic [2:0] {
+    LANE_NONE,
+    LANE_REDUCE_ADD,
+    LANE_REDUCE_MIN,
+    LANE_REDUCE_MAX,
+    LANE_REDUCE_AND,
+    LANE_REDUCE_OR,
+    LANE_SHUFFLE
+} lane_op_t;
+
+// mask stack operation enum
+typedef enum logic [1:0] {
+    MASK_NONE,
+    MASK_SPLIT,
+    MASK_ELSE,
+    MASK_JOIN
+} mask_op_t;
+
 // reg input mux
 typedef enum logic [2:0] {
     ALU_OUT,
     LSU_OUT,
     IMMEDIATE,
     PC_PLUS_1,
-    VECTOR_TO_SCALAR
+    VECTOR_TO_SCALAR,
+    SHARED_MEMORY_OUT,
+    SHUFFLE_OUT
 } reg_input_mux_t;
 
 // sign extend function
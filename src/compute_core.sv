@@ -5,15 +5,35 @@
 
 module compute_core#(
     parameter int WARPS_PER_CORE = 4,            // Number of warps to in each core
-    parameter int THREADS_PER_WARP = 32          // Number of threads per warp (max 32)
+    parameter int BLOCKS_PER_CORE = 4,           // Number of block slots, each block runs on num_warps_per_block consecutive warps
+    parameter int THREADS_PER_WARP = 32,         // Number of threads per warp (max 32)
+    parameter int UNIFORM_LOAD_BROADCAST = 1,    // Whether loads from an address shared by all active lanes are sent only once
+    parameter int WARP_SWITCH_ON_STALL = 1,      // Whether the scheduler switches away from warps waiting on memory or on a fetch
+    parameter int SCHEDULER_POLICY = `SCHEDULER_LOOSE_ROUND_ROBIN, // How the next warp is chosen
+    parameter int SCHEDULER_ACTIVE_WARPS = 2,    // Two-level scheduling: number of warps in the active set
+    parameter int PREFETCH_DEPTH = 4,            // Number of sequential instructions each fetcher buffers ahead of its warp
+    parameter int REGISTER_SCOREBOARD = 1,       // Whether warps keep issuing past their memory instructions until they need a pending register
+    parameter int WRITE_BUFFER_DEPTH = 64,       // Number of posted stores buffered between the LSUs and memory (0 = stores wait for memory)
+    parameter int WRITE_COMBINE_WINDOW = 16,     // Number of cycles a posted store waits to be combined with later stores to the same word
+    parameter int WRITE_COMBINE_LINE_SIZE = 4,   // Number of adjacent words whose posted stores drain together
+    parameter int SHARED_MEMORY_SIZE = 1024,     // Number of scratchpad words, split evenly between the resident blocks
+    parameter int SHARED_MEMORY_BANKS = 32,      // Number of scratchpad banks, each serves one word per cycle
+    parameter int MASK_STACK_DEPTH = 8,          // Number of nested divergent regions (split ... join) each warp can be in
+    parameter int ZERO_MASK_SKIP = 1,            // Whether vector instructions of a warp without active lanes only advance its pc
+    parameter int MUL_LATENCY = 2,               // Number of cycles the ALUs take for MUL, MULH, MAC and DOT4
+    parameter int DIV_LATENCY = 8                // Number of cycles the ALUs take for DIV and REM
     )(
     input wire clk,
     input wire reset,
 
-    input logic start,
-    output logic done,
+    // Block slots, started and reset independently of each other
+    input logic [BLOCKS_PER_CORE-1:0] start,
+    input logic [BLOCKS_PER_CORE-1:0] block_reset,
+    input logic [BLOCKS_PER_CORE-1:0] block_relaunch,   // The slot's block finished, start its warps again on the new block_id
+    output logic [BLOCKS_PER_CORE-1:0] done,
 
-    input data_t block_id,
+    input data_t block_id [BLOCKS_PER_CORE],
+    input data_t resident_blocks,       // Number of slots the dispatcher hands blocks to, at most BLOCKS_PER_CORE
     input kernel_config_t kernel_config,
 
     // Instruction Memory
@@ -25,12 +45,26 @@ module compute_core#(
     // Data Memory
     output logic [NUM_LSUS-1:0] data_mem_read_valid,
     output data_memory_address_t data_mem_read_address [NUM_LSUS],
+    output atomic_op_t data_mem_read_atomic_op [NUM_LSUS],
+    output data_t data_mem_read_atomic_operand [NUM_LSUS],
+    output data_t data_mem_read_atomic_compare [NUM_LSUS],
     input logic [NUM_LSUS-1:0] data_mem_read_ready,
     input data_t data_mem_read_data [NUM_LSUS],
     output logic [NUM_LSUS-1:0] data_mem_write_valid,
     output data_memory_address_t data_mem_write_address [NUM_LSUS],
     output data_t data_mem_write_data [NUM_LSUS],
-    input logic [NUM_LSUS-1:0] data_mem_write_ready
+    input logic [NUM_LSUS-1:0] data_mem_write_ready,
+
+    // Statistics
+    output data_t num_warps_fetching,
+    output data_t num_warps_at_barrier,     // Number of warps waiting for the other warps of their block at a barrier in this cycle
+    output logic uniform_load_executed,
+    output logic scheduler_idle,            // The current warp cannot make progress in this cycle
+    output data_t posted_stores,            // Number of stores accepted by the write buffer in this cycle
+    output data_t drained_stores,           // Number of stores the write buffer sent to memory in this cycle
+    output logic shared_memory_access,      // A warp started a scratchpad access in this cycle
+    output logic shared_memory_bank_conflict, // A scratchpad access needs another cycle because of a bank conflict
+    output logic zero_mask_skipped          // A vector instruction was skipped in this cycle, as no lane of its warp is active
 );
 
 typedef logic [THREADS_PER_WARP-1:0] warp_mask_t;
@@ -47,18 +81,100 @@ assign current_warp_state = warp_state[current_warp];
 
 data_t rs1 [THREADS_PER_WARP];
 data_t rs2 [THREADS_PER_WARP];
+data_t rs3 [THREADS_PER_WARP];
 
 instruction_t fetched_instruction [WARPS_PER_CORE];
 
 // Alu specific variables
 data_t alu_out [THREADS_PER_WARP];
 
+// Cross-lane unit outputs, the reduction goes to a scalar register, the shuffle to every lane
+data_t reduction_out;
+data_t shuffle_out [THREADS_PER_WARP];
+
 // LSU specific variables
 logic decoded_mem_read_enable [THREADS_PER_WARP];
 logic decoded_mem_write_enable [THREADS_PER_WARP];
 lsu_state_t lsu_state [THREADS_PER_WARP];
 data_t lsu_out [THREADS_PER_WARP];
 
+// LSU side of the write buffer
+logic [NUM_LSUS-1:0] lsu_data_read_valid;
+data_memory_address_t lsu_data_read_address [NUM_LSUS];
+atomic_op_t lsu_data_read_atomic_op [NUM_LSUS];
+data_t lsu_data_read_atomic_operand [NUM_LSUS];
+data_t lsu_data_read_atomic_compare [NUM_LSUS];
+logic [NUM_LSUS-1:0] lsu_data_read_ready;
+data_t lsu_data_read_data [NUM_LSUS];
+logic [NUM_LSUS-1:0] lsu_data_write_valid;
+data_memory_address_t lsu_data_write_address [NUM_LSUS];
+data_t lsu_data_write_data [NUM_LSUS];
+logic [NUM_LSUS-1:0] lsu_data_write_ready;
+logic [BLOCKS_PER_CORE-1:0] write_buffer_empty;     // Every store posted by the slot reached memory
+logic [BLOCKS_PER_CORE-1:0] write_buffer_flush;
+data_t write_buffer_slot;                           // Slot of the warp driving the LSUs
+
+// Uniform-address loads: only the first active lane sends a request, its result is broadcast to the whole warp
+logic uniform_load;
+int uniform_load_leader;
+data_t broadcast_lsu_out [THREADS_PER_WARP];
+
+// The LSUs are shared by the warps of the core. A warp executing a memory instruction owns them from WARP_REQUEST
+// until WARP_UPDATE, so the scheduler can run other warps while the requests are in flight
+logic lsu_busy;
+int lsu_owner;
+int lsu_warp;                   // Warp driving the LSUs, the owner if there is one, the current warp otherwise
+logic lsu_requesting;           // Some LSU has not sent its request yet
+logic lsu_waiting;              // Some LSU has not received its response yet
+logic warp_uses_lsu [WARPS_PER_CORE];
+logic warp_ready [WARPS_PER_CORE];
+logic warp_active [WARPS_PER_CORE];     // Two-level scheduling: the warp is in the active set
+logic current_warp_fast_path;           // The current instruction can skip WARP_WAIT
+int current_warp_alu_latency;           // Number of WARP_WAIT cycles the ALUs need for the current instruction
+int alu_wait_cycles;                    // WARP_WAIT cycles the current warp has already spent on a multi-cycle ALU instruction
+
+// rs1 is overwritten by other warps once the owner is switched away, so the broadcast is latched when the requests are sent
+logic lsu_uniform_load;
+int lsu_uniform_load_leader;
+
+// With REGISTER_SCOREBOARD, a memory instruction detaches from its warp once all of its requests have been sent.
+// The warp goes on with the following instructions while the LSUs wait for the responses, then the loaded value is
+// written back through a second register file port. The LSUs are driven by the fields latched when they were taken,
+// as the owner decodes new instructions in the meantime
+logic lsu_detached;
+logic lsu_writeback;                    // All responses of the detached instruction arrived, write back and release the LSUs
+logic issued_mem_read_enable;
+logic issued_mem_write_enable;
+logic issued_scalar_instruction;
+warp_mask_t issued_execution_mask;
+logic [4:0] issued_rd_address;
+
+// Inputs of the LSUs, from the latched fields while detached and from the warp driving them otherwise
+warp_state_t lsu_warp_state;
+logic lsu_mem_read_enable;
+logic lsu_mem_write_enable;
+logic lsu_scalar_instruction;
+warp_mask_t lsu_execution_mask;
+
+// Per warp scoreboard of the registers that a detached load has yet to write, indexed like the decoded addresses
+logic [31:0] pending_vector_registers [WARPS_PER_CORE];
+logic [31:0] pending_scalar_registers [WARPS_PER_CORE];
+logic warp_blocked [WARPS_PER_CORE];    // The instruction reads or writes a pending register, or halts or reaches a barrier before its memory instruction finished
+
+// A vector instruction has no effect when s1 is zero, so the warp goes from WARP_REQUEST straight back to WARP_FETCH
+// without reading operands or using the ALUs and LSUs. Vector-to-scalar instructions still run, they write a scalar register
+logic warp_zero_mask_skip [WARPS_PER_CORE];
+
+// Shared memory (scratchpad), accessed by the current warp in WARP_WAIT. The warp stays current until every lane was
+// served, as the addresses and the data come from the shared rs1 / rs2
+data_t shared_memory_slot_size;         // Number of words of each resident block
+data_t shared_memory_offset [THREADS_PER_WARP];
+logic warp_uses_shared_memory [WARPS_PER_CORE];
+logic shared_memory_request;
+logic shared_memory_done;
+data_t shared_memory_address [THREADS_PER_WARP];
+data_t shared_memory_out [THREADS_PER_WARP];
+
 // Decoded instruction fields per warp
 logic decoded_reg_write_enable [WARPS_PER_CORE];
 reg_input_mux_t decoded_reg_input_mux [WARPS_PER_CORE];
@@ -68,8 +184,15 @@ logic decoded_scalar_instruction [WARPS_PER_CORE];
 logic [4:0] decoded_rd_address [WARPS_PER_CORE];
 logic [4:0] decoded_rs1_address [WARPS_PER_CORE];
 logic [4:0] decoded_rs2_address [WARPS_PER_CORE];
-logic [4:0] decoded_alu_instruction [WARPS_PER_CORE];
+logic [4:0] decoded_rs3_address [WARPS_PER_CORE];
+alu_instruction_t decoded_alu_instruction [WARPS_PER_CORE];
+atomic_op_t decoded_atomic_op [WARPS_PER_CORE];
+lane_op_t decoded_lane_op [WARPS_PER_CORE];
+mask_op_t decoded_mask_op [WARPS_PER_CORE];
 logic decoded_halt [WARPS_PER_CORE];
+logic decoded_barrier [WARPS_PER_CORE];
+logic decoded_shared_read_enable [WARPS_PER_CORE];
+logic decoded_shared_write_enable [WARPS_PER_CORE];
 
 // scalar registers
 warp_mask_t warp_execution_mask [WARPS_PER_CORE];
@@ -77,20 +200,231 @@ warp_mask_t current_warp_execution_mask;
 assign current_warp_execution_mask = warp_execution_mask[current_warp];
 data_t scalar_rs1;
 data_t scalar_rs2;
+data_t scalar_rs3;
 data_t scalar_lsu_out;
 data_t scalar_alu_out;
 lsu_state_t scalar_lsu_state;
 
-data_t vector_to_scalar_data [WARPS_PER_CORE];
+data_t vector_to_scalar_data [WARPS_PER_CORE];   // Written to the scalar rd in WARP_UPDATE, also the new s1 of the mask stack instructions
+
+// SIMT mask stack, entry i holds the mask before the i-th enclosing split and the mask of its else path
+warp_mask_t mask_stack_saved [WARPS_PER_CORE][MASK_STACK_DEPTH];
+warp_mask_t mask_stack_else [WARPS_PER_CORE][MASK_STACK_DEPTH];
+int mask_stack_size [WARPS_PER_CORE];
+warp_mask_t mask_stack_next_mask;   // s1 after the mask stack instruction of the current warp
+logic mask_stack_skip;              // No lane takes the path that follows, jump over it
 
 instruction_memory_address_t pc [WARPS_PER_CORE];
 instruction_memory_address_t next_pc [WARPS_PER_CORE];
 
-logic start_execution; // EDA: Unimportant hack used because of EDA tooling
+logic [BLOCKS_PER_CORE-1:0] block_started;
+logic [BLOCKS_PER_CORE-1:0] block_halted;   // Every warp of the started block reached WARP_DONE
+logic [BLOCKS_PER_CORE-1:0] block_released; // Every warp of the block that has not halted waits at a barrier
 
 data_t num_warps;
 assign num_warps = kernel_config.num_warps_per_block;
 
+// Slot s runs its block on warps s * num_warps ... (s + 1) * num_warps - 1, warps beyond the last slot stay idle
+int warp_slot [WARPS_PER_CORE];             // BLOCKS_PER_CORE if the warp belongs to no slot
+data_t warp_index [WARPS_PER_CORE];         // Index of the warp within its block
+data_t warp_block_id [WARPS_PER_CORE];
+logic warp_reset [WARPS_PER_CORE];          // Clears the registers of the warp, with the core or with its slot
+logic warp_relaunch [WARPS_PER_CORE];       // Only restores the execution mask, the other registers are left to the next block
+
+always_comb begin
+    for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+        warp_slot[i] = num_warps == 0 || i / num_warps >= BLOCKS_PER_CORE ? BLOCKS_PER_CORE : i / num_warps;
+        warp_index[i] = num_warps == 0 ? 0 : i % num_warps;
+        warp_block_id[i] = warp_slot[i] < BLOCKS_PER_CORE ? block_id[warp_slot[i]] : 0;
+        warp_reset[i] = reset || (warp_slot[i] < BLOCKS_PER_CORE && block_reset[warp_slot[i]]);
+        warp_relaunch[i] = warp_slot[i] < BLOCKS_PER_CORE && block_relaunch[warp_slot[i]];
+    end
+end
+
+// Address operands are latched in WARP_REQUEST and used by the LSUs in the first cycle of WARP_WAIT,
+// every load instruction uses the same immediate, so comparing rs1 is enough to find a uniform address
+// Atomics to a single address still need one request per lane, every lane updates the word
+always_comb begin
+    uniform_load = (UNIFORM_LOAD_BROADCAST == 1) && decoded_mem_read_enable[current_warp] && !decoded_scalar_instruction[current_warp] &&
+        decoded_atomic_op[current_warp] == ATOMIC_NONE;
+    uniform_load_leader = -1;
+    for (int i = 0; i < THREADS_PER_WARP; i = i + 1) begin
+        if (current_warp_execution_mask[i]) begin
+            if (uniform_load_leader == -1) begin
+                uniform_load_leader = i;
+            end else if (rs1[i] != rs1[uniform_load_leader]) begin
+                uniform_load = 0;
+            end
+        end
+    end
+    if (uniform_load_leader == -1) begin
+        uniform_load = 0;
+    end
+
+    for (int i = 0; i < THREADS_PER_WARP; i = i + 1) begin
+        broadcast_lsu_out[i] = lsu_uniform_load ? lsu_out[lsu_uniform_load_leader] : lsu_out[i];
+    end
+end
+
+assign uniform_load_executed = lsu_uniform_load && lsu_busy &&
+    (lsu_detached ? lsu_writeback : (lsu_owner == current_warp && current_warp_state == WARP_EXECUTE));
+
+assign lsu_warp = lsu_busy ? lsu_owner : current_warp;
+assign write_buffer_slot = data_t'(warp_slot[lsu_warp] % BLOCKS_PER_CORE);
+
+assign lsu_writeback = lsu_detached && !lsu_waiting;
+
+// Detached LSUs see WARP_WAIT until every response arrived, then WARP_UPDATE for the write-back cycle
+always_comb begin
+    if (lsu_detached) begin
+        lsu_warp_state = lsu_waiting ? WARP_WAIT : WARP_UPDATE;
+        lsu_mem_read_enable = issued_mem_read_enable;
+        lsu_mem_write_enable = issued_mem_write_enable;
+        lsu_scalar_instruction = issued_scalar_instruction;
+        lsu_execution_mask = issued_execution_mask;
+    end else begin
+        lsu_warp_state = warp_state[lsu_warp];
+        lsu_mem_read_enable = decoded_mem_read_enable[lsu_warp];
+        lsu_mem_write_enable = decoded_mem_write_enable[lsu_warp];
+        lsu_scalar_instruction = decoded_scalar_instruction[lsu_warp];
+        lsu_execution_mask = warp_execution_mask[lsu_warp];
+    end
+end
+
+// Every resident block sees its own part of the scratchpad, so a block that is alone on its core gets all of it
+assign shared_memory_request = current_warp_state == WARP_WAIT && warp_uses_shared_memory[current_warp];
+assign shared_memory_slot_size = SHARED_MEMORY_SIZE / resident_blocks;
+always_comb begin
+    for (int i = 0; i < THREADS_PER_WARP; i = i + 1) begin
+        shared_memory_offset[i] = rs1[i] + decoded_immediate[current_warp];
+        shared_memory_address[i] = data_t'(warp_slot[current_warp] % BLOCKS_PER_CORE) * shared_memory_slot_size + shared_memory_offset[i];
+    end
+end
+
+// Addresses past the part of the block would reach into the scratchpad of another block
+always @(posedge clk) begin
+    if (!reset && shared_memory_request) begin
+        for (int i = 0; i < THREADS_PER_WARP; i = i + 1) begin
+            if (current_warp_execution_mask[i] && shared_memory_offset[i] >= shared_memory_slot_size) begin
+                $error("Block: %0d: Warp %0d: Shared memory address %0d out of range, the block has %0d words",
+                    warp_block_id[current_warp], warp_index[current_warp], shared_memory_offset[i], shared_memory_slot_size);
+            end
+        end
+    end
+end
+
+// The mask stack instructions only need s1 and the predicate read in WARP_REQUEST, not the ALU
+always_comb begin
+    int top;
+    top = mask_stack_size[current_warp] > 0 ? mask_stack_size[current_warp] - 1 : 0;
+    case (decoded_mask_op[current_warp])
+        MASK_SPLIT: mask_stack_next_mask = warp_mask_t'(scalar_rs1) & warp_mask_t'(scalar_rs2);
+        MASK_ELSE: mask_stack_next_mask = mask_stack_else[current_warp][top];
+        MASK_JOIN: mask_stack_next_mask = mask_stack_saved[current_warp][top];
+        default: mask_stack_next_mask = current_warp_execution_mask;
+    endcase
+    mask_stack_skip = decoded_mask_op[current_warp] != MASK_NONE && decoded_mask_op[current_warp] != MASK_JOIN &&
+        mask_stack_next_mask == 0;
+end
+
+assign zero_mask_skipped = current_warp_state == WARP_REQUEST && warp_zero_mask_skip[current_warp] && !warp_blocked[current_warp];
+
+assign scheduler_idle = (block_started & ~block_halted) != 0 && !warp_ready[current_warp];
+
+// Once every warp of a block halted its last stores should not wait for the combining window, so the write buffer drains
+// the stores of its slot right away. The other slots keep combining theirs
+always_comb begin
+    block_halted = block_started;
+    for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+        if (warp_slot[i] < BLOCKS_PER_CORE && warp_state[i] != WARP_DONE) begin
+            block_halted[warp_slot[i]] = 0;
+        end
+    end
+    write_buffer_flush = block_halted;
+end
+
+// Branches, jumps and vector-to-scalar instructions use the ALU result in WARP_EXECUTE, so the ALUs need the
+// WARP_WAIT cycle to compute it from the operands read in WARP_REQUEST. Other instructions without memory
+// operations only use it in WARP_UPDATE and go straight to WARP_EXECUTE, unless the ALUs take more than one cycle
+always_comb begin
+    case (decoded_alu_instruction[current_warp])
+        MUL, MULH, MAC, DOT4: current_warp_alu_latency = MUL_LATENCY;
+        DIV, REM: current_warp_alu_latency = DIV_LATENCY;
+        default: current_warp_alu_latency = 1;
+    endcase
+end
+
+assign current_warp_fast_path = !warp_uses_lsu[current_warp] && !warp_uses_shared_memory[current_warp] && !decoded_branch[current_warp] &&
+    current_warp_alu_latency == 1 && decoded_alu_instruction[current_warp] != JAL && decoded_alu_instruction[current_warp] != JALR &&
+    (decoded_reg_input_mux[current_warp] != VECTOR_TO_SCALAR || decoded_mask_op[current_warp] != MASK_NONE);
+
+always_comb begin
+    lsu_requesting = scalar_lsu_state == LSU_REQUESTING;
+    lsu_waiting = scalar_lsu_state == LSU_REQUESTING || scalar_lsu_state == LSU_WAITING;
+    for (int i = 0; i < THREADS_PER_WARP; i = i + 1) begin
+        if (lsu_state[i] == LSU_REQUESTING) begin
+            lsu_requesting = 1;
+        end
+        if (lsu_state[i] == LSU_REQUESTING || lsu_state[i] == LSU_WAITING) begin
+            lsu_waiting = 1;
+        end
+    end
+end
+
+// A warp can be scheduled unless it is fetching, waiting on its own memory requests, needs the LSUs while they are busy,
+// or (with the scoreboard) needs a register that a detached load has not written yet
+// The scoreboard does not tell the register files apart, and the execution mask (s1) is an operand of every instruction
+// Decoded fields are only valid from WARP_REQUEST onwards
+always_comb begin
+    for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+        logic [31:0] pending;
+        pending = pending_vector_registers[i] | pending_scalar_registers[i];
+        warp_uses_lsu[i] = decoded_mem_read_enable[i] || decoded_mem_write_enable[i];
+        warp_uses_shared_memory[i] = decoded_shared_read_enable[i] || decoded_shared_write_enable[i];
+        warp_zero_mask_skip[i] = ZERO_MASK_SKIP == 1 && !decoded_scalar_instruction[i] && decoded_reg_input_mux[i] != VECTOR_TO_SCALAR &&
+            warp_execution_mask[i] == 0;
+        // A skipped instruction reads and writes nothing, it only has to wait for a pending s1
+        warp_blocked[i] = warp_zero_mask_skip[i] ? pending_scalar_registers[i][1] :
+            pending[decoded_rs1_address[i]] || pending[decoded_rs2_address[i]] || pending[decoded_rd_address[i]] ||
+            pending_scalar_registers[i][1] || ((decoded_halt[i] || decoded_barrier[i]) && lsu_busy && lsu_owner == i);
+        case (warp_state[i])
+            WARP_EXECUTE, WARP_UPDATE: warp_ready[i] = 1;
+            WARP_REQUEST: warp_ready[i] = !(warp_uses_lsu[i] && lsu_busy && !warp_zero_mask_skip[i]) && !warp_blocked[i];
+            WARP_WAIT: warp_ready[i] = !(warp_uses_lsu[i] && (REGISTER_SCOREBOARD == 1 ? lsu_requesting : lsu_waiting));
+            default: warp_ready[i] = 0;
+        endcase
+    end
+end
+
+// Number of warps stalled waiting on an instruction fetch or at a barrier in this cycle
+always_comb begin
+    num_warps_fetching = 0;
+    num_warps_at_barrier = 0;
+    for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+        if (warp_state[i] == WARP_FETCH) begin
+            num_warps_fetching = num_warps_fetching + 1;
+        end
+        if (warp_state[i] == WARP_BARRIER) begin
+            num_warps_at_barrier = num_warps_at_barrier + 1;
+        end
+    end
+end
+
+// A barrier is released once every warp of the block arrived at it, warps that already halted do not hold it up
+always_comb begin
+    block_released = 0;
+    for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+        if (warp_slot[i] < BLOCKS_PER_CORE && warp_state[i] == WARP_BARRIER) begin
+            block_released[warp_slot[i]] = 1;
+        end
+    end
+    for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+        if (warp_slot[i] < BLOCKS_PER_CORE && warp_state[i] != WARP_BARRIER && warp_state[i] != WARP_DONE) begin
+            block_released[warp_slot[i]] = 0;
+        end
+    end
+end
+
 alu warp_alu_inst(
     .clk(clk),
     .reset(reset),
@@ -99,6 +433,7 @@ alu warp_alu_inst(
     .pc(pc[current_warp]),
     .rs1(scalar_rs1),
     .rs2(scalar_rs2),
+    .rs3(scalar_rs3),
     .imm(decoded_immediate[current_warp]),
     .instruction(decoded_alu_instruction[current_warp]),
 
@@ -108,26 +443,33 @@ alu warp_alu_inst(
 lsu warp_lsu_inst (
     .clk(clk),
     .reset(reset),
-    .enable(decoded_scalar_instruction[current_warp]),
+    .enable(lsu_scalar_instruction),
 
-    .warp_state(warp_state[current_warp]),
+    .warp_state(lsu_warp_state),
 
-    .decoded_mem_read_enable(decoded_mem_read_enable[current_warp]),
-    .decoded_mem_write_enable(decoded_mem_write_enable[current_warp]),
+    .decoded_mem_read_enable(lsu_mem_read_enable),
+    .decoded_mem_write_enable(lsu_mem_write_enable),
+    .decoded_atomic_op(ATOMIC_NONE),      // Atomics are vector instructions only
 
     .rs1(scalar_rs1),
     .rs2(scalar_rs2),
-    .imm(decoded_immediate[current_warp]),
+    .rs3({`DATA_WIDTH{1'b0}}),
+    .imm(decoded_immediate[lsu_warp]),
+
+    .broadcast_follower(1'b0),
 
     // Data Memory connections
-    .mem_read_valid(data_mem_read_valid[THREADS_PER_WARP]),
-    .mem_read_address(data_mem_read_address[THREADS_PER_WARP]),
-    .mem_read_ready(data_mem_read_ready[THREADS_PER_WARP]),
-    .mem_read_data(data_mem_read_data[THREADS_PER_WARP]),
-    .mem_write_valid(data_mem_write_valid[THREADS_PER_WARP]),
-    .mem_write_address(data_mem_write_address[THREADS_PER_WARP]),
-    .mem_write_data(data_mem_write_data[THREADS_PER_WARP]),
-    .mem_write_ready(data_mem_write_ready[THREADS_PER_WARP]),
+    .mem_read_valid(lsu_data_read_valid[THREADS_PER_WARP]),
+    .mem_read_address(lsu_data_read_address[THREADS_PER_WARP]),
+    .mem_read_atomic_op(lsu_data_read_atomic_op[THREADS_PER_WARP]),
+    .mem_read_atomic_operand(lsu_data_read_atomic_operand[THREADS_PER_WARP]),
+    .mem_read_atomic_compare(lsu_data_read_atomic_compare[THREADS_PER_WARP]),
+    .mem_read_ready(lsu_data_read_ready[THREADS_PER_WARP]),
+    .mem_read_data(lsu_data_read_data[THREADS_PER_WARP]),
+    .mem_write_valid(lsu_data_write_valid[THREADS_PER_WARP]),
+    .mem_write_address(lsu_data_write_address[THREADS_PER_WARP]),
+    .mem_write_data(lsu_data_write_data[THREADS_PER_WARP]),
+    .mem_write_ready(lsu_data_write_ready[THREADS_PER_WARP]),
 
     .lsu_state(scalar_lsu_state),
     .lsu_out(scalar_lsu_out)
@@ -135,8 +477,8 @@ lsu warp_lsu_inst (
 
 always @(posedge clk) begin
     if (reset) begin
-        $display("Resetting core %0d", block_id);
-        start_execution <= 0;
+        $display("Resetting core");
+        block_started <= 0;
         done <= 0;
         for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
             warp_state[i] <= WARP_IDLE;
@@ -144,53 +486,103 @@ always @(posedge clk) begin
             pc[i] <= 0;
             next_pc[i] <= 0;
             current_warp <= 0;
+            warp_active[i] <= 0;
+            pending_vector_registers[i] <= 0;
+            pending_scalar_registers[i] <= 0;
+            mask_stack_size[i] <= 0;
         end
-    end else if (!start_execution) begin
-        if (start) begin
-            $display("Starting execution of block %d", block_id);
-            // Set all warps to fetch state on start
-            start_execution <= 1;
-            current_warp <= 0;
-            for (int i = 0; i < num_warps; i = i + 1) begin
-                warp_state[i] <= WARP_FETCH;
-                fetcher_state[i] <= FETCHER_IDLE;
-                pc[i] <= kernel_config.base_instructions_address;
-                next_pc[i] <= kernel_config.base_instructions_address;
-            end
-        end
+        lsu_busy <= 0;
+        lsu_owner <= 0;
+        lsu_detached <= 0;
+        lsu_uniform_load <= 0;
+        lsu_uniform_load_leader <= 0;
+        alu_wait_cycles <= 0;
     end else begin
-        // In parallel, check if fetchers are done, and if so, move to decode
-        for (int i = 0; i < num_warps; i = i + 1) begin
-            if (warp_state[i] == WARP_FETCH && fetcher_state[i] == FETCHER_DONE) begin
-                $display("Block: %0d: Warp %0d: Fetched instruction %h at address %h", block_id, i, fetched_instruction[i], pc[i]);
-                warp_state[i] <= WARP_DECODE;
-            end
+        // A detached memory instruction completed, its load was written back, so the LSUs and the register are free again
+        if (lsu_writeback) begin
+            lsu_busy <= 0;
+            lsu_detached <= 0;
+            pending_vector_registers[lsu_owner][issued_rd_address] <= 0;
+            pending_scalar_registers[lsu_owner][issued_rd_address] <= 0;
         end
 
-        // If all warps are done, we are done
-        for (int i = 0; i < num_warps; i = i + 1) begin
-            if (warp_state[i] != WARP_DONE) begin
-                done <= 0;
-                break;
+        // In parallel, check if fetchers are done, and if so, move to request
+        // The decoder latches the instruction in the same cycle, so there is no separate decode state
+        for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+            if (warp_state[i] == WARP_FETCH && fetcher_state[i] == FETCHER_DONE) begin
+                $display("Block: %0d: Warp %0d: Fetched instruction %h at address %h", warp_block_id[i], warp_index[i], fetched_instruction[i], pc[i]);
+                warp_state[i] <= WARP_REQUEST;
             end
-            done <= 1;
         end
 
+        // A block is done once all of its warps are done
+        // Posted stores of the block have to reach memory before it is done
+        done <= block_halted & write_buffer_empty;
+
         // Choose a warp to execute
         // We don't choose warps that are in one of the following states:
         // - WARP_IDLE - that means that the warp is not active
         // - WARP_DONE - that means that the warp has finished execution
+        // - WARP_BARRIER - that means that the warp waits for the other warps of its block
         // - WARP_FETCH - that means that the warp is fetching instructions
-        // For now we do not change state unless we are in WARP_UPDATE
-        if (current_warp_state == WARP_UPDATE || current_warp_state == WARP_DONE) begin
-            int next_warp = (current_warp + 1) % num_warps;
+        // - WARP_WAIT with memory requests in flight, or WARP_REQUEST while another warp owns the LSUs
+        // - WARP_REQUEST with an operand that a detached load has yet to write (scoreboard)
+        // We change warps after WARP_UPDATE, and with WARP_SWITCH_ON_STALL also when the current warp stalls on a fetch
+        // or on memory (once all of its requests have been sent, as they read the shared rs1 / rs2)
+        // Greedy-then-oldest keeps the current warp after WARP_UPDATE and only leaves it when it stalls
+        if (current_warp_state == WARP_IDLE || current_warp_state == WARP_DONE || current_warp_state == WARP_BARRIER ||
+            (current_warp_state == WARP_UPDATE && !(SCHEDULER_POLICY == `SCHEDULER_GREEDY_THEN_OLDEST && WARP_SWITCH_ON_STALL == 1)) ||
+            ((WARP_SWITCH_ON_STALL == 1) && (current_warp_state == WARP_FETCH || (!warp_ready[current_warp] && !lsu_requesting)))) begin
+            int next_warp = (current_warp + 1) % WARPS_PER_CORE;
             int found_warp = -1;
-            $display("Block: %0d: Choosing next warp", block_id);
-            for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
-                int warp_index = (next_warp + i) % num_warps;
-                if ((warp_state[warp_index] != WARP_IDLE) && (warp_state[warp_index] != WARP_FETCH) && (warp_state[warp_index] != WARP_DONE)) begin
-                    found_warp = warp_index;
-                    break;
+            $display("Block: %0d: Choosing next warp", warp_block_id[current_warp]);
+            if (SCHEDULER_POLICY == `SCHEDULER_GREEDY_THEN_OLDEST) begin
+                // All warps of a block start together, so within a block the oldest warp is the one with the lowest index
+                for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+                    if (i != current_warp && warp_ready[i]) begin
+                        found_warp = i;
+                        break;
+                    end
+                end
+            end else if (SCHEDULER_POLICY == `SCHEDULER_TWO_LEVEL) begin
+                // Warps that finish or stall on memory leave the active set, which makes room for a pending warp
+                logic demote_current = current_warp_state == WARP_DONE || current_warp_state == WARP_BARRIER ||
+                    (warp_uses_lsu[current_warp] && (current_warp_state == WARP_UPDATE || !warp_ready[current_warp]));
+                int num_active = 0;
+                for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+                    if (warp_active[i] && !(demote_current && i == current_warp)) begin
+                        num_active = num_active + 1;
+                    end
+                end
+                if (demote_current) begin
+                    warp_active[current_warp] <= 0;
+                end
+
+                // Round-robin over the active set, a pending warp is only promoted when there is room for it
+                for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+                    int next_index = (next_warp + i) % WARPS_PER_CORE;
+                    if (warp_ready[next_index] && warp_active[next_index] && !(demote_current && next_index == current_warp)) begin
+                        found_warp = next_index;
+                        break;
+                    end
+                end
+                if (found_warp == -1 && num_active < SCHEDULER_ACTIVE_WARPS) begin
+                    for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+                        int next_index = (next_warp + i) % WARPS_PER_CORE;
+                        if (warp_ready[next_index]) begin
+                            found_warp = next_index;
+                            warp_active[next_index] <= 1;
+                            break;
+                        end
+                    end
+                end
+            end else begin
+                for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+                    int next_index = (next_warp + i) % WARPS_PER_CORE;
+                    if (warp_ready[next_index]) begin
+                        found_warp = next_index;
+                        break;
+                    end
                 end
             end
             if (found_warp != -1) begin
@@ -203,45 +595,80 @@ always @(posedge clk) begin
 
         case (current_warp_state)
             WARP_IDLE: begin
-                $display("Block: %0d: Warp %0d: Idle", block_id, current_warp);
+                // No block is running on this warp
             end
             WARP_FETCH: begin
                 // not possible to choose a warp that is fetching cause
                 // fetching is done in parallel
             end
-            WARP_DECODE: begin
-                // decoding takes one cycle
-                warp_state[current_warp] <= WARP_REQUEST;
-            end
             WARP_REQUEST: begin
                 // takes one cycle cause we are just changing the LSU state
-                warp_state[current_warp] <= WARP_WAIT;
+                // memory instructions wait here until the LSUs are released by the warp owning them
+                // instructions that only need their result in WARP_UPDATE skip WARP_WAIT
+                alu_wait_cycles <= 0;
+                if (warp_blocked[current_warp]) begin
+                    // Wait for the scoreboard, the operands are read again once the pending load was written back
+                end else if (warp_zero_mask_skip[current_warp]) begin
+                    $display("Block: %0d: Warp %0d: Skipping instruction %h at address %h, no lane is active", warp_block_id[current_warp], warp_index[current_warp], fetched_instruction[current_warp], pc[current_warp]);
+                    pc[current_warp] <= pc[current_warp] + 1;
+                    warp_state[current_warp] <= WARP_FETCH;
+                end else if (!warp_uses_lsu[current_warp]) begin
+                    warp_state[current_warp] <= current_warp_fast_path ? WARP_EXECUTE : WARP_WAIT;
+                end else if (!lsu_busy) begin
+                    lsu_busy <= 1;
+                    lsu_owner <= current_warp;
+                    lsu_uniform_load <= 0;
+                    issued_mem_read_enable <= decoded_mem_read_enable[current_warp];
+                    issued_mem_write_enable <= decoded_mem_write_enable[current_warp];
+                    issued_scalar_instruction <= decoded_scalar_instruction[current_warp];
+                    issued_execution_mask <= current_warp_execution_mask;
+                    issued_rd_address <= decoded_rd_address[current_warp];
+                    warp_state[current_warp] <= WARP_WAIT;
+                end
             end
             WARP_WAIT: begin
-                reg any_lsu_waiting = 1'b0;
-                for (int i = 0; i < THREADS_PER_WARP; i++) begin
-                    // Make sure no lsu_state = REQUESTING or WAITING
-                    if (lsu_state[i] == LSU_REQUESTING || lsu_state[i] == LSU_WAITING) begin
-                        any_lsu_waiting = 1'b1;
-                        break;
-                    end
-                end
-
-                if (scalar_lsu_state == LSU_REQUESTING || scalar_lsu_state == LSU_WAITING) begin
-                    any_lsu_waiting = 1'b1;
+                // The LSUs send their requests in the first cycle of WARP_WAIT, while rs1 still belongs to this warp
+                if (warp_uses_lsu[current_warp] && lsu_requesting) begin
+                    lsu_uniform_load <= uniform_load;
+                    lsu_uniform_load_leader <= uniform_load_leader;
                 end
 
-                // If no LSU is waiting for a response, move onto the next stage
-                if (!any_lsu_waiting) begin
+                if (warp_uses_shared_memory[current_warp]) begin
+                    // The scratchpad takes one cycle, plus one for each bank conflict
+                    if (shared_memory_done) begin
+                        warp_state[current_warp] <= WARP_EXECUTE;
+                    end
+                end else if (REGISTER_SCOREBOARD == 1 && warp_uses_lsu[current_warp]) begin
+                    // Once every request was sent, leave the responses to the LSUs and mark the loaded register as pending
+                    if (!lsu_requesting) begin
+                        lsu_detached <= 1;
+                        if (decoded_mem_read_enable[current_warp] && decoded_reg_write_enable[current_warp]) begin
+                            if (decoded_scalar_instruction[current_warp]) begin
+                                if (decoded_rd_address[current_warp] > 0) begin
+                                    pending_scalar_registers[current_warp][decoded_rd_address[current_warp]] <= 1;
+                                end
+                            end else if (decoded_rd_address[current_warp] >= 4) begin
+                                pending_vector_registers[current_warp][decoded_rd_address[current_warp]] <= 1;
+                            end
+                        end
+                        warp_state[current_warp] <= WARP_EXECUTE;
+                    end
+                end else if (alu_wait_cycles < current_warp_alu_latency - 1) begin
+                    // The ALUs are still multiplying or dividing, the warp keeps them until the result is done
+                    alu_wait_cycles <= alu_wait_cycles + 1;
+                end else if (!warp_uses_lsu[current_warp] || !lsu_waiting) begin
+                    // If no LSU is waiting for a response, move onto the next stage
                     warp_state[current_warp] <= WARP_EXECUTE;
                 end
             end
             WARP_EXECUTE: begin
                 $display("===================================");
                 $display("Mask: %32b", warp_execution_mask[current_warp]);
-                $display("Block: %0d: Warp %0d: Executing instruction %h at address %h", block_id, current_warp, fetched_instruction[current_warp], pc[current_warp]);
+                $display("Block: %0d: Warp %0d: Executing instruction %h at address %h", warp_block_id[current_warp], warp_index[current_warp], fetched_instruction[current_warp], pc[current_warp]);
                 $display("Instruction opcode: %b", fetched_instruction[current_warp][6:0]);
-                if (decoded_scalar_instruction[current_warp]) begin
+                if (decoded_mask_op[current_warp] != MASK_NONE) begin
+                    next_pc[current_warp] <= mask_stack_skip ? pc[current_warp] + decoded_immediate[current_warp] : pc[current_warp] + 1;
+                end else if (decoded_scalar_instruction[current_warp]) begin
                     if (decoded_branch[current_warp]) begin
                         // Branch instruction
                         if (scalar_alu_out == 1) begin
@@ -266,7 +693,32 @@ always @(posedge clk) begin
                 $display("===================================");
                 warp_state[current_warp] <= WARP_UPDATE;
 
-                if (decoded_reg_input_mux[current_warp] == VECTOR_TO_SCALAR) begin
+                case (decoded_mask_op[current_warp])
+                    MASK_SPLIT: begin
+                        if (mask_stack_size[current_warp] == MASK_STACK_DEPTH) begin
+                            $error("Block: %0d: Warp %0d: Mask stack overflow", warp_block_id[current_warp], warp_index[current_warp]);
+                        end else begin
+                            mask_stack_saved[current_warp][mask_stack_size[current_warp]] <= warp_mask_t'(scalar_rs1);
+                            mask_stack_else[current_warp][mask_stack_size[current_warp]] <= warp_mask_t'(scalar_rs1) & ~warp_mask_t'(scalar_rs2);
+                            mask_stack_size[current_warp] <= mask_stack_size[current_warp] + 1;
+                        end
+                    end
+                    MASK_JOIN: begin
+                        if (mask_stack_size[current_warp] == 0) begin
+                            $error("Block: %0d: Warp %0d: Join without a split", warp_block_id[current_warp], warp_index[current_warp]);
+                        end else begin
+                            mask_stack_size[current_warp] <= mask_stack_size[current_warp] - 1;
+                        end
+                    end
+                    default: begin
+                    end
+                endcase
+
+                if (decoded_mask_op[current_warp] != MASK_NONE) begin
+                    vector_to_scalar_data[current_warp] <= data_t'(mask_stack_next_mask);
+                end else if (decoded_reg_input_mux[current_warp] == VECTOR_TO_SCALAR && decoded_lane_op[current_warp] != LANE_NONE) begin
+                    vector_to_scalar_data[current_warp] <= reduction_out;
+                end else if (decoded_reg_input_mux[current_warp] == VECTOR_TO_SCALAR) begin
                     data_t scalar_write_value;
                     scalar_write_value = {`DATA_WIDTH{1'b0}};
                     for (int i = 0; i < THREADS_PER_WARP; i++) begin
@@ -279,9 +731,17 @@ always @(posedge clk) begin
 
             end
             WARP_UPDATE: begin
+                if (lsu_busy && lsu_owner == current_warp && !lsu_detached) begin
+                    lsu_busy <= 0;
+                end
+
                 if (decoded_halt[current_warp]) begin
-                    $display("Block: %0d: Warp %0d: Finished executing instruction %h", block_id, current_warp, fetched_instruction[current_warp]);
+                    $display("Block: %0d: Warp %0d: Finished executing instruction %h", warp_block_id[current_warp], warp_index[current_warp], fetched_instruction[current_warp]);
                     warp_state[current_warp] <= WARP_DONE;
+                end else if (decoded_barrier[current_warp]) begin
+                    $display("Block: %0d: Warp %0d: Waiting at barrier", warp_block_id[current_warp], warp_index[current_warp]);
+                    pc[current_warp] <= next_pc[current_warp];
+                    warp_state[current_warp] <= WARP_BARRIER;
                 end else begin
                     pc[current_warp] <= next_pc[current_warp];
                     warp_state[current_warp] <= WARP_FETCH;
@@ -290,14 +750,72 @@ always @(posedge clk) begin
             WARP_DONE: begin
                 // we chillin
             end
+            WARP_BARRIER: begin
+                // Released below, together with the other warps of the block
+            end
         endcase
+
+        // All warps of a block leave the barrier in the same cycle
+        for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+            if (warp_slot[i] < BLOCKS_PER_CORE && warp_state[i] == WARP_BARRIER && block_released[warp_slot[i]]) begin
+                warp_state[i] <= WARP_FETCH;
+            end
+        end
+
+        // Blocks start and finish independently, a slot is reset on its own once its block is done while
+        // the other blocks of the core keep running
+        for (int s = 0; s < BLOCKS_PER_CORE; s = s + 1) begin
+            if (block_reset[s]) begin
+                block_started[s] <= 0;
+                done[s] <= 0;
+                for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+                    if (warp_slot[i] == s) begin
+                        warp_state[i] <= WARP_IDLE;
+                        warp_active[i] <= 0;
+                    end
+                end
+            end else if (block_relaunch[s] || (start[s] && !block_started[s])) begin
+                // A relaunch skips the reset, the warps of the slot are all done, so only their pc and state need to change
+                // (x1 - x3 follow block_id by themselves)
+                int num_active = 0;
+                $display("Starting execution of block %d", block_id[s]);
+                block_started[s] <= 1;
+                done[s] <= 0;
+                for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+                    if (warp_active[i] && warp_state[i] != WARP_IDLE && warp_state[i] != WARP_DONE) begin
+                        num_active = num_active + 1;
+                    end
+                end
+                // Set the warps of the block to fetch state on start
+                for (int i = 0; i < WARPS_PER_CORE; i = i + 1) begin
+                    if (warp_slot[i] == s) begin
+                        warp_state[i] <= WARP_FETCH;
+                        fetcher_state[i] <= FETCHER_IDLE;
+                        pc[i] <= kernel_config.base_instructions_address;
+                        next_pc[i] <= kernel_config.base_instructions_address;
+                        warp_active[i] <= num_active < SCHEDULER_ACTIVE_WARPS;
+                        pending_vector_registers[i] <= 0;
+                        pending_scalar_registers[i] <= 0;
+                        mask_stack_size[i] <= 0;
+                        if (num_active < SCHEDULER_ACTIVE_WARPS) begin
+                            num_active = num_active + 1;
+                        end
+                    end
+                end
+            end
+        end
     end
 end
 
 // This block generates warp control circuitry
 generate
 for (genvar i = 0; i < WARPS_PER_CORE; i = i + 1) begin : g_warp
-    fetcher fetcher_inst(
+    // Detached loads are written back by the LSUs, not in WARP_UPDATE
+    wire detached_load = REGISTER_SCOREBOARD == 1 && decoded_reg_input_mux[i] == LSU_OUT;
+
+    fetcher #(
+        .PREFETCH_DEPTH(PREFETCH_DEPTH)
+    ) fetcher_inst(
         .clk(clk),
         .reset(reset),
 
@@ -319,12 +837,15 @@ for (genvar i = 0; i < WARPS_PER_CORE; i = i + 1) begin : g_warp
         .clk(clk),
         .reset(reset),
         .warp_state(warp_state[i]),
+        .fetcher_state(fetcher_state[i]),
 
         .instruction(fetched_instruction[i]),
 
         .decoded_reg_write_enable(decoded_reg_write_enable[i]),
         .decoded_mem_write_enable(decoded_mem_write_enable[i]),
         .decoded_mem_read_enable(decoded_mem_read_enable[i]),
+        .decoded_shared_write_enable(decoded_shared_write_enable[i]),
+        .decoded_shared_read_enable(decoded_shared_read_enable[i]),
         .decoded_branch(decoded_branch[i]),
         .decoded_scalar_instruction(decoded_scalar_instruction[i]),
         .decoded_reg_input_mux(decoded_reg_input_mux[i]),
@@ -332,28 +853,38 @@ for (genvar i = 0; i < WARPS_PER_CORE; i = i + 1) begin : g_warp
         .decoded_rd_address(decoded_rd_address[i]),
         .decoded_rs1_address(decoded_rs1_address[i]),
         .decoded_rs2_address(decoded_rs2_address[i]),
+        .decoded_rs3_address(decoded_rs3_address[i]),
         .decoded_alu_instruction(decoded_alu_instruction[i]),
+        .decoded_atomic_op(decoded_atomic_op[i]),
+        .decoded_lane_op(decoded_lane_op[i]),
+        .decoded_mask_op(decoded_mask_op[i]),
 
-        .decoded_halt(decoded_halt[i])
+        .decoded_halt(decoded_halt[i]),
+        .decoded_barrier(decoded_barrier[i])
     );
 
     scalar_reg_file #(
         .DATA_WIDTH(32)
     ) scalar_reg_file_inst (
         .clk(clk),
-        .reset(reset),
+        .reset(warp_reset[i]),
+        .relaunch(warp_relaunch[i]),
         .enable((current_warp == i)), // Enable when current_warp matches and warp is active
 
         .warp_execution_mask(warp_execution_mask[i]),
 
         .warp_state(warp_state[i]),
 
-        .decoded_reg_write_enable(decoded_reg_write_enable[i] & (decoded_scalar_instruction[i] | decoded_reg_input_mux[current_warp] == VECTOR_TO_SCALAR)),
+        .decoded_reg_write_enable(decoded_reg_write_enable[i] & (decoded_scalar_instruction[i] | decoded_reg_input_mux[current_warp] == VECTOR_TO_SCALAR) & !detached_load),
         .decoded_reg_input_mux(decoded_reg_input_mux[i]),
         .decoded_immediate(decoded_immediate[i]),
         .decoded_rd_address(decoded_rd_address[i]),
         .decoded_rs1_address(decoded_rs1_address[i]),
         .decoded_rs2_address(decoded_rs2_address[i]),
+        .decoded_rs3_address(decoded_rs3_address[i]),
+
+        .writeback_enable(lsu_writeback && lsu_owner == i && issued_mem_read_enable && issued_scalar_instruction),
+        .writeback_rd_address(issued_rd_address),
 
         .alu_out(scalar_alu_out),
         .lsu_out(scalar_lsu_out),
@@ -361,45 +892,156 @@ for (genvar i = 0; i < WARPS_PER_CORE; i = i + 1) begin : g_warp
         .vector_to_scalar_data(vector_to_scalar_data[i]),
 
         .rs1(scalar_rs1),
-        .rs2(scalar_rs2)
+        .rs2(scalar_rs2),
+        .rs3(scalar_rs3)
     );
 
     reg_file #(
             .THREADS_PER_WARP(THREADS_PER_WARP)
         ) reg_file_inst (
             .clk(clk),
-            .reset(reset),
+            .reset(warp_reset[i]),
             .enable((current_warp == i)), // Enable when current_warp matches and warp is active
 
             // Thread enable signals (execution mask)
             .thread_enable(warp_execution_mask[i]),
 
             // Warp and block identifiers
-            .warp_id(i),
-            .block_id(block_id),
+            .warp_id(warp_index[i]),
+            .block_id(warp_block_id[i]),
             .block_size(kernel_config.num_warps_per_block * THREADS_PER_WARP),
             .warp_state(warp_state[i]),
 
             // Decoded instruction fields for this warp
-            .decoded_reg_write_enable(decoded_reg_write_enable[i] & !decoded_scalar_instruction[i]),
+            .decoded_reg_write_enable(decoded_reg_write_enable[i] & !decoded_scalar_instruction[i] & !detached_load),
             .decoded_reg_input_mux(decoded_reg_input_mux[i]),
             .decoded_immediate(decoded_immediate[i]),
             .decoded_rd_address(decoded_rd_address[i]),
             .decoded_rs1_address(decoded_rs1_address[i]),
             .decoded_rs2_address(decoded_rs2_address[i]),
+            .decoded_rs3_address(decoded_rs3_address[i]),
+
+            // Write-back of detached loads
+            .writeback_enable(lsu_writeback && lsu_owner == i && issued_mem_read_enable && !issued_scalar_instruction),
+            .writeback_rd_address(issued_rd_address),
+            .writeback_thread_enable(issued_execution_mask),
 
-            // Inputs from ALU and LSU per thread
+            // Inputs from ALU, LSU, shared memory and the cross-lane unit per thread
             .alu_out(alu_out), // ALU outputs for all threads
-            .lsu_out(lsu_out),
+            .lsu_out(broadcast_lsu_out),
+            .shared_memory_out(shared_memory_out),
+            .shuffle_out(shuffle_out),
 
             // Outputs per thread
             .rs1(rs1),
-            .rs2(rs2)
+            .rs2(rs2),
+            .rs3(rs3)
         );
 end
 endgenerate
 
 
+// Stores are posted to the write buffer, which forwards loads and drains stores through the core's data memory ports
+generate
+    if (WRITE_BUFFER_DEPTH > 0) begin : g_write_buffer
+        write_buffer #(
+            .NUM_CONSUMERS(NUM_LSUS),
+            .DEPTH(WRITE_BUFFER_DEPTH),
+            .COMBINE_WINDOW(WRITE_COMBINE_WINDOW),
+            .LINE_SIZE(WRITE_COMBINE_LINE_SIZE),
+            .NUM_SLOTS(BLOCKS_PER_CORE)
+        ) write_buffer_inst (
+            .clk(clk),
+            .reset(reset),
+
+            .consumer_read_valid(lsu_data_read_valid),
+            .consumer_read_address(lsu_data_read_address),
+            .consumer_read_atomic_op(lsu_data_read_atomic_op),
+            .consumer_read_atomic_operand(lsu_data_read_atomic_operand),
+            .consumer_read_atomic_compare(lsu_data_read_atomic_compare),
+            .consumer_read_ready(lsu_data_read_ready),
+            .consumer_read_data(lsu_data_read_data),
+            .consumer_write_valid(lsu_data_write_valid),
+            .consumer_write_address(lsu_data_write_address),
+            .consumer_write_data(lsu_data_write_data),
+            .consumer_write_ready(lsu_data_write_ready),
+            .consumer_write_slot(write_buffer_slot),
+
+            .mem_read_valid(data_mem_read_valid),
+            .mem_read_address(data_mem_read_address),
+            .mem_read_atomic_op(data_mem_read_atomic_op),
+            .mem_read_atomic_operand(data_mem_read_atomic_operand),
+            .mem_read_atomic_compare(data_mem_read_atomic_compare),
+            .mem_read_ready(data_mem_read_ready),
+            .mem_read_data(data_mem_read_data),
+            .mem_write_valid(data_mem_write_valid),
+            .mem_write_address(data_mem_write_address),
+            .mem_write_data(data_mem_write_data),
+            .mem_write_ready(data_mem_write_ready),
+
+            .flush(write_buffer_flush),
+            .empty(write_buffer_empty),
+
+            .posted_stores(posted_stores),
+            .drained_stores(drained_stores)
+        );
+    end else begin : g_no_write_buffer
+        assign data_mem_read_valid = lsu_data_read_valid;
+        assign lsu_data_read_ready = data_mem_read_ready;
+        assign data_mem_write_valid = lsu_data_write_valid;
+        assign lsu_data_write_ready = data_mem_write_ready;
+        assign write_buffer_empty = {BLOCKS_PER_CORE{1'b1}};
+        assign posted_stores = 0;
+        assign drained_stores = 0;
+        for (genvar i = 0; i < NUM_LSUS; i = i + 1) begin : g_lsu_connect
+            assign data_mem_read_address[i] = lsu_data_read_address[i];
+            assign data_mem_read_atomic_op[i] = lsu_data_read_atomic_op[i];
+            assign data_mem_read_atomic_operand[i] = lsu_data_read_atomic_operand[i];
+            assign data_mem_read_atomic_compare[i] = lsu_data_read_atomic_compare[i];
+            assign lsu_data_read_data[i] = data_mem_read_data[i];
+            assign data_mem_write_address[i] = lsu_data_write_address[i];
+            assign data_mem_write_data[i] = lsu_data_write_data[i];
+        end
+    end
+endgenerate
+
+shared_memory #(
+    .THREADS_PER_WARP(THREADS_PER_WARP),
+    .SIZE(SHARED_MEMORY_SIZE),
+    .NUM_BANKS(SHARED_MEMORY_BANKS)
+) shared_memory_inst (
+    .clk(clk),
+    .reset(reset),
+
+    .request_valid(shared_memory_request),
+    .write_enable(decoded_shared_write_enable[current_warp]),
+    .thread_enable(current_warp_execution_mask),
+    .address(shared_memory_address),
+    .write_data(rs2),
+    .read_data(shared_memory_out),
+    .done(shared_memory_done),
+
+    .access_started(shared_memory_access),
+    .bank_conflict(shared_memory_bank_conflict)
+);
+
+// Reductions and shuffles read the operands of every lane, so they run next to the per-lane ALUs, in the same cycle
+cross_lane_unit #(
+    .THREADS_PER_WARP(THREADS_PER_WARP)
+) cross_lane_unit_inst (
+    .clk(clk),
+    .reset(reset),
+    .enable(decoded_lane_op[current_warp] != LANE_NONE),
+
+    .thread_enable(current_warp_execution_mask),
+    .lane_op(decoded_lane_op[current_warp]),
+    .rs1(rs1),
+    .rs2(rs2),
+
+    .reduction_out(reduction_out),
+    .shuffle_out(shuffle_out)
+);
+
 // This block generates shared core resources
 generate
     for (genvar i = 0; i < THREADS_PER_WARP; i = i + 1) begin : g_alus
@@ -412,35 +1054,44 @@ generate
             .pc(pc[current_warp]),
             .rs1(rs1[i]),
             .rs2(rs2[i]),
+            .rs3(rs3[i]),
             .imm(decoded_immediate[current_warp]),
             .instruction(decoded_alu_instruction[current_warp]),
 
             .alu_out(alu_out[i])
         );
 
+        wire lsu_enable = lsu_execution_mask[i] & !lsu_scalar_instruction;
         lsu lsu_inst(
             .clk(clk),
             .reset(reset),
-            .enable(t_enable),
+            .enable(lsu_enable),
 
-            .warp_state(warp_state[current_warp]),
+            .warp_state(lsu_warp_state),
 
-            .decoded_mem_read_enable(decoded_mem_read_enable[current_warp]),
-            .decoded_mem_write_enable(decoded_mem_write_enable[current_warp]),
+            .decoded_mem_read_enable(lsu_mem_read_enable),
+            .decoded_mem_write_enable(lsu_mem_write_enable),
+            .decoded_atomic_op(decoded_atomic_op[lsu_warp]),
 
             .rs1(rs1[i]),
             .rs2(rs2[i]),
-            .imm(decoded_immediate[current_warp]),
+            .rs3(rs3[i]),
+            .imm(decoded_immediate[lsu_warp]),
+
+            .broadcast_follower(uniform_load && uniform_load_leader != i),
 
             // Data Memory connections
-            .mem_read_valid(data_mem_read_valid[i]),
-            .mem_read_address(data_mem_read_address[i]),
-            .mem_read_ready(data_mem_read_ready[i]),
-            .mem_read_data(data_mem_read_data[i]),
-            .mem_write_valid(data_mem_write_valid[i]),
-            .mem_write_address(data_mem_write_address[i]),
-            .mem_write_data(data_mem_write_data[i]),
-            .mem_write_ready(data_mem_write_ready[i]),
+            .mem_read_valid(lsu_data_read_valid[i]),
+            .mem_read_address(lsu_data_read_address[i]),
+            .mem_read_atomic_op(lsu_data_read_atomic_op[i]),
+            .mem_read_atomic_operand(lsu_data_read_atomic_operand[i]),
+            .mem_read_atomic_compare(lsu_data_read_atomic_compare[i]),
+            .mem_read_ready(lsu_data_read_ready[i]),
+            .mem_read_data(lsu_data_read_data[i]),
+            .mem_write_valid(lsu_data_write_valid[i]),
+            .mem_write_address(lsu_data_write_address[i]),
+            .mem_write_data(lsu_data_write_data[i]),
+            .mem_write_ready(lsu_data_write_ready[i]),
 
             .lsu_state(lsu_state[i]),
             .lsu_out(lsu_out[i])
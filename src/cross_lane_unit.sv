@@ -0,0 +1,65 @@
+`default_nettype none
+`timescale 1ns/1ns
+
+`include "common.sv"
+
+// CROSS-LANE UNIT
+// > Executes the instructions that read the operands of other lanes of the warp, next to the per-lane ALUs
+// > Reductions combine rs1 of the active lanes into a single value for a scalar register, inactive lanes do not
+//   contribute (without active lanes the result is the identity of the operation)
+// > Shuffles give each lane rs1 of the lane selected by its rs2, a broadcast is a shuffle with the same rs2 in every lane
+// > The register file only reads the operands of active lanes, so shuffling from an inactive lane gives an undefined value
+// > Like the ALUs, the results are registered and valid in the cycle after the operands
+module cross_lane_unit #(
+    parameter int THREADS_PER_WARP = 32
+) (
+    input wire clk,
+    input wire reset,
+    input wire enable,
+
+    input logic [THREADS_PER_WARP-1:0] thread_enable,
+    input lane_op_t lane_op,
+    input data_t rs1 [THREADS_PER_WARP],
+    input data_t rs2 [THREADS_PER_WARP],
+
+    output data_t reduction_out,
+    output data_t shuffle_out [THREADS_PER_WARP]
+);
+
+always @(posedge clk) begin
+    if (reset) begin
+        reduction_out <= {`DATA_WIDTH{1'b0}};
+        for (int i = 0; i < THREADS_PER_WARP; i++) begin
+            shuffle_out[i] <= {`DATA_WIDTH{1'b0}};
+        end
+    end else if (enable) begin
+        data_t result;
+        case (lane_op)
+            LANE_REDUCE_AND: result = {`DATA_WIDTH{1'b1}};
+            LANE_REDUCE_MIN: result = {1'b0, {(`DATA_WIDTH-1){1'b1}}};
+            LANE_REDUCE_MAX: result = {1'b1, {(`DATA_WIDTH-1){1'b0}}};
+            default: result = {`DATA_WIDTH{1'b0}};
+        endcase
+
+        for (int i = 0; i < THREADS_PER_WARP; i++) begin
+            if (thread_enable[i]) begin
+                case (lane_op)
+                    LANE_REDUCE_ADD: result = result + rs1[i];
+                    LANE_REDUCE_MIN: result = $signed(rs1[i]) < $signed(result) ? rs1[i] : result;
+                    LANE_REDUCE_MAX: result = $signed(rs1[i]) > $signed(result) ? rs1[i] : result;
+                    LANE_REDUCE_AND: result = result & rs1[i];
+                    LANE_REDUCE_OR: result = result | rs1[i];
+                    default: begin
+                    end
+                endcase
+            end
+        end
+        reduction_out <= result;
+
+        for (int i = 0; i < THREADS_PER_WARP; i++) begin
+            shuffle_out[i] <= rs1[rs2[i] % THREADS_PER_WARP];
+        end
+    end
+end
+
+endmodule
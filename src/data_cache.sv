@@ -0,0 +1,617 @@
+`default_nettype none
+`timescale 1ns/1ns
+
+`include "common.sv"
+
+// DATA CACHE
+// > Per core L1 cache between the LSUs and the data memory controller
+// > Set-associative with round-robin replacement within a set
+// > Either write-through without write-allocate, or write-back with write-allocate
+// > Non-blocking: every line miss is tracked by an MSHR which owns a memory port, other requests keep hitting meanwhile
+// > Requests to a line that already has an MSHR wait for it instead of allocating another one
+// > Write-back caches write their dirty lines to memory once flush is raised at the end of a kernel
+// > Coalescing: a lookup serves every pending request to the same line (one warp instruction) in a single transaction
+// > Atomics bypass the cache: they are sent to memory through a write port, and the cached copy of their line is dropped.
+//   A dirty line is written back and refilled by an MSHR before the atomic is sent
+module data_cache #(
+    parameter int NUM_CONSUMERS = 33,       // Number of LSUs served by this cache
+    parameter int CACHE_SIZE = 1024,        // Total number of words held by the cache
+    parameter int LINE_SIZE = 4,            // Number of words per cache line
+    parameter int ASSOCIATIVITY = 2,        // Number of ways per set
+    parameter int NUM_MSHRS = 4,            // Number of line misses that can be outstanding at once
+    parameter int NUM_WRITE_PORTS = 4,      // Number of memory ports used by write-through stores and flushes
+    parameter int NUM_LOOKUP_PORTS = 4,     // Number of requests looked up per cycle
+    parameter int WRITE_BACK = 0,           // 0 = write-through, 1 = write-back
+    parameter int COALESCE = 1              // Whether requests to the same line are served by a single lookup
+) (
+    input wire clk,
+    input wire reset,
+
+    // Consumer Interface (LSUs)
+    input wire [NUM_CONSUMERS-1:0] consumer_read_valid,
+    input data_memory_address_t consumer_read_address [NUM_CONSUMERS],
+    input atomic_op_t consumer_read_atomic_op [NUM_CONSUMERS],
+    input data_t consumer_read_atomic_operand [NUM_CONSUMERS],
+    input data_t consumer_read_atomic_compare [NUM_CONSUMERS],
+    output logic [NUM_CONSUMERS-1:0] consumer_read_ready,
+    output data_t consumer_read_data [NUM_CONSUMERS],
+    input wire [NUM_CONSUMERS-1:0] consumer_write_valid,
+    input data_memory_address_t consumer_write_address [NUM_CONSUMERS],
+    input data_t consumer_write_data [NUM_CONSUMERS],
+    output logic [NUM_CONSUMERS-1:0] consumer_write_ready,
+
+    // Memory Interface (Data Memory Controller)
+    // Ports [0, NUM_MSHRS) belong to the MSHRs, the following NUM_WRITE_PORTS ports carry stores, flushes and atomics
+    output logic [NUM_MSHRS+NUM_WRITE_PORTS-1:0] mem_read_valid,
+    output data_memory_address_t mem_read_address [NUM_MSHRS+NUM_WRITE_PORTS],
+    output atomic_op_t mem_read_atomic_op [NUM_MSHRS+NUM_WRITE_PORTS],
+    output data_t mem_read_atomic_operand [NUM_MSHRS+NUM_WRITE_PORTS],
+    output data_t mem_read_atomic_compare [NUM_MSHRS+NUM_WRITE_PORTS],
+    input wire [NUM_MSHRS+NUM_WRITE_PORTS-1:0] mem_read_ready,
+    input data_t mem_read_data [NUM_MSHRS+NUM_WRITE_PORTS],
+    output logic [NUM_MSHRS+NUM_WRITE_PORTS-1:0] mem_write_valid,
+    output data_memory_address_t mem_write_address [NUM_MSHRS+NUM_WRITE_PORTS],
+    output data_t mem_write_data [NUM_MSHRS+NUM_WRITE_PORTS],
+    input wire [NUM_MSHRS+NUM_WRITE_PORTS-1:0] mem_write_ready,
+
+    // Flush Interface
+    input wire flush,       // Write all dirty lines back to memory
+    output logic flushed,   // Memory is up to date with the cache
+
+    // Statistics
+    output data_t hits,
+    output data_t misses,
+    output data_t transactions              // Number of lookups, (hits + misses) / transactions is the coalescing efficiency
+);
+localparam int NUM_SETS = CACHE_SIZE / (LINE_SIZE * ASSOCIATIVITY);
+localparam int NUM_LINES = NUM_SETS * ASSOCIATIVITY;
+
+// Tags hold the whole line address, which keeps the lookup independent of the set count
+logic line_valid [NUM_SETS][ASSOCIATIVITY];
+logic line_dirty [NUM_SETS][ASSOCIATIVITY];
+data_memory_address_t line_tag [NUM_SETS][ASSOCIATIVITY];
+data_t line_data [NUM_SETS][ASSOCIATIVITY][LINE_SIZE];
+int replacement_way [NUM_SETS];
+
+// Miss status holding registers, each one evicts (if dirty) and then fills a single line
+mshr_state_t mshr_state [NUM_MSHRS];
+cache_port_state_t mshr_port_state [NUM_MSHRS];
+data_memory_address_t mshr_line_address [NUM_MSHRS];
+data_memory_address_t mshr_evicted_line_address [NUM_MSHRS];
+int mshr_set [NUM_MSHRS];
+int mshr_way [NUM_MSHRS];
+int mshr_offset [NUM_MSHRS];
+
+// Write ports, flush writes use consumer -1 as they do not need to be acknowledged
+// An atomic uses the read side of the port, and its response is returned to the consumer like a load
+cache_port_state_t write_port_state [NUM_WRITE_PORTS];
+int write_port_consumer [NUM_WRITE_PORTS];
+logic write_port_atomic [NUM_WRITE_PORTS];
+
+// Per consumer request bookkeeping
+logic [NUM_CONSUMERS-1:0] consumer_write_issued;    // The store was handed to a write port and waits for memory
+logic [NUM_CONSUMERS-1:0] consumer_missed;          // The request was already counted as a miss
+logic [NUM_CONSUMERS-1:0] consumer_atomic_issued;   // The atomic was handed to a write port and waits for memory
+
+// Round-robin pointer, so that no LSU is starved by the lookup ports
+int next_consumer;
+
+// Flush progress
+int flush_line;
+int flush_offset;
+
+// Blocking copies of the MSHR and write port occupancy, updated by allocations made earlier in the same cycle
+logic mshr_busy [NUM_MSHRS];
+logic mshr_busy_evicting [NUM_MSHRS];
+data_memory_address_t mshr_busy_line_address [NUM_MSHRS];
+data_memory_address_t mshr_busy_evicted_line_address [NUM_MSHRS];
+int mshr_busy_set [NUM_MSHRS];
+int mshr_busy_way [NUM_MSHRS];
+logic write_port_busy [NUM_WRITE_PORTS];
+data_memory_address_t write_port_busy_line_address [NUM_WRITE_PORTS];
+
+// Requests served in this cycle by the lookup of another request to the same line
+logic [NUM_CONSUMERS-1:0] consumer_coalesced;
+
+// Lines written by store hits in this cycle, they can not be picked as victims until the store lands
+int num_stored_lines;
+int stored_set [NUM_LOOKUP_PORTS];
+int stored_way [NUM_LOOKUP_PORTS];
+
+// Lines dropped by atomics in this cycle, later lookups in the same cycle miss them
+int num_dropped_lines;
+int dropped_set [NUM_LOOKUP_PORTS];
+int dropped_way [NUM_LOOKUP_PORTS];
+
+always @(posedge clk) begin
+    if (reset) begin
+        for (int i = 0; i < NUM_CONSUMERS; i++) begin
+            consumer_read_ready[i] <= 0;
+            consumer_read_data[i] <= 0;
+            consumer_write_ready[i] <= 0;
+        end
+        for (int i = 0; i < NUM_MSHRS + NUM_WRITE_PORTS; i++) begin
+            mem_read_valid[i] <= 0;
+            mem_read_address[i] <= 0;
+            mem_read_atomic_op[i] <= ATOMIC_NONE;
+            mem_read_atomic_operand[i] <= 0;
+            mem_read_atomic_compare[i] <= 0;
+            mem_write_valid[i] <= 0;
+            mem_write_address[i] <= 0;
+            mem_write_data[i] <= 0;
+        end
+        for (int i = 0; i < NUM_SETS; i++) begin
+            for (int j = 0; j < ASSOCIATIVITY; j++) begin
+                line_valid[i][j] <= 0;
+                line_dirty[i][j] <= 0;
+            end
+            replacement_way[i] <= 0;
+        end
+        for (int i = 0; i < NUM_MSHRS; i++) begin
+            mshr_state[i] <= MSHR_IDLE;
+            mshr_port_state[i] <= PORT_IDLE;
+        end
+        for (int i = 0; i < NUM_WRITE_PORTS; i++) begin
+            write_port_state[i] <= PORT_IDLE;
+            write_port_atomic[i] <= 0;
+        end
+        consumer_write_issued <= 0;
+        consumer_missed <= 0;
+        consumer_atomic_issued <= 0;
+        next_consumer <= 0;
+        flush_line <= 0;
+        flush_offset <= 0;
+        flushed <= 0;
+        hits <= 0;
+        misses <= 0;
+        transactions <= 0;
+    end else begin
+        int num_lookups = 0;
+        int num_hits = 0;
+        int num_misses = 0;
+        int last_consumer = -1;
+
+        // Wait until the consumer acknowledges it received the response, then reset
+        for (int i = 0; i < NUM_CONSUMERS; i++) begin
+            if (consumer_read_ready[i] && !consumer_read_valid[i]) begin
+                consumer_read_ready[i] <= 0;
+            end
+            if (consumer_write_ready[i] && !consumer_write_valid[i]) begin
+                consumer_write_ready[i] <= 0;
+            end
+        end
+
+        // Write ports forward a single store to memory, the store is acknowledged once memory accepted it
+        // An atomic is answered with the value memory held before the update
+        for (int i = 0; i < NUM_WRITE_PORTS; i++) begin
+            case (write_port_state[i])
+                PORT_REQUESTING: begin
+                    if (write_port_atomic[i]) begin
+                        if (mem_read_ready[NUM_MSHRS + i]) begin
+                            mem_read_valid[NUM_MSHRS + i] <= 0;
+                            mem_read_atomic_op[NUM_MSHRS + i] <= ATOMIC_NONE;
+                            consumer_read_ready[write_port_consumer[i]] <= 1;
+                            consumer_read_data[write_port_consumer[i]] <= mem_read_data[NUM_MSHRS + i];
+                            consumer_atomic_issued[write_port_consumer[i]] <= 0;
+                            write_port_state[i] <= PORT_RELEASING;
+                        end
+                    end else if (mem_write_ready[NUM_MSHRS + i]) begin
+                        mem_write_valid[NUM_MSHRS + i] <= 0;
+                        if (write_port_consumer[i] != -1) begin
+                            consumer_write_ready[write_port_consumer[i]] <= 1;
+                            consumer_write_issued[write_port_consumer[i]] <= 0;
+                        end
+                        write_port_state[i] <= PORT_RELEASING;
+                    end
+                end
+                PORT_RELEASING: begin
+                    if (!mem_write_ready[NUM_MSHRS + i] && !mem_read_ready[NUM_MSHRS + i]) begin
+                        write_port_state[i] <= PORT_IDLE;
+                    end
+                end
+                default: begin
+                end
+            endcase
+        end
+
+        // MSHRs write back the evicted line and fill the new one word by word
+        for (int i = 0; i < NUM_MSHRS; i++) begin
+            case (mshr_port_state[i])
+                PORT_REQUESTING: begin
+                    if (mshr_state[i] == MSHR_WRITEBACK && mem_write_ready[i]) begin
+                        mem_write_valid[i] <= 0;
+                        mshr_port_state[i] <= PORT_RELEASING;
+                    end else if (mshr_state[i] == MSHR_FILL && mem_read_ready[i]) begin
+                        mem_read_valid[i] <= 0;
+                        line_data[mshr_set[i]][mshr_way[i]][mshr_offset[i]] <= mem_read_data[i];
+                        if (mshr_offset[i] == LINE_SIZE - 1) begin
+                            line_tag[mshr_set[i]][mshr_way[i]] <= mshr_line_address[i];
+                            line_valid[mshr_set[i]][mshr_way[i]] <= 1;
+                            line_dirty[mshr_set[i]][mshr_way[i]] <= 0;
+                        end
+                        mshr_port_state[i] <= PORT_RELEASING;
+                    end
+                end
+                PORT_RELEASING: begin
+                    // Wait for the memory controller to release the channel before sending another request
+                    if (!mem_read_ready[i] && !mem_write_ready[i]) begin
+                        if (mshr_offset[i] != LINE_SIZE - 1) begin
+                            int offset = mshr_offset[i] + 1;
+                            if (mshr_state[i] == MSHR_WRITEBACK) begin
+                                mem_write_valid[i] <= 1;
+                                mem_write_address[i] <= mshr_evicted_line_address[i] * LINE_SIZE + data_memory_address_t'(offset);
+                                mem_write_data[i] <= line_data[mshr_set[i]][mshr_way[i]][offset];
+                            end else begin
+                                mem_read_valid[i] <= 1;
+                                mem_read_address[i] <= mshr_line_address[i] * LINE_SIZE + data_memory_address_t'(offset);
+                            end
+                            mshr_offset[i] <= offset;
+                            mshr_port_state[i] <= PORT_REQUESTING;
+                        end else if (mshr_state[i] == MSHR_WRITEBACK) begin
+                            // The evicted line is in memory, start filling the new one
+                            mem_read_valid[i] <= 1;
+                            mem_read_address[i] <= mshr_line_address[i] * LINE_SIZE;
+                            mshr_offset[i] <= 0;
+                            mshr_state[i] <= MSHR_FILL;
+                            mshr_port_state[i] <= PORT_REQUESTING;
+                        end else begin
+                            mshr_state[i] <= MSHR_IDLE;
+                            mshr_port_state[i] <= PORT_IDLE;
+                        end
+                    end
+                end
+                default: begin
+                end
+            endcase
+        end
+
+        for (int i = 0; i < NUM_MSHRS; i++) begin
+            mshr_busy[i] = mshr_state[i] != MSHR_IDLE;
+            mshr_busy_evicting[i] = mshr_state[i] == MSHR_WRITEBACK;
+            mshr_busy_line_address[i] = mshr_line_address[i];
+            mshr_busy_evicted_line_address[i] = mshr_evicted_line_address[i];
+            mshr_busy_set[i] = mshr_set[i];
+            mshr_busy_way[i] = mshr_way[i];
+        end
+        for (int i = 0; i < NUM_WRITE_PORTS; i++) begin
+            write_port_busy[i] = write_port_state[i] != PORT_IDLE;
+            write_port_busy_line_address[i] = (write_port_atomic[i] ? mem_read_address[NUM_MSHRS + i] : mem_write_address[NUM_MSHRS + i]) / LINE_SIZE;
+        end
+        num_stored_lines = 0;
+        num_dropped_lines = 0;
+        consumer_coalesced = 0;
+
+        // Look up to NUM_LOOKUP_PORTS pending requests
+        for (int k = 0; k < NUM_CONSUMERS; k++) begin
+            int consumer = (next_consumer + k) % NUM_CONSUMERS;
+            logic is_read = consumer_read_valid[consumer] && !consumer_read_ready[consumer] && !consumer_atomic_issued[consumer] && !consumer_coalesced[consumer];
+            logic is_atomic = is_read && consumer_read_atomic_op[consumer] != ATOMIC_NONE;
+            logic is_write = consumer_write_valid[consumer] && !consumer_write_ready[consumer] && !consumer_write_issued[consumer] && !consumer_coalesced[consumer];
+
+            if (num_lookups == NUM_LOOKUP_PORTS) begin
+                break;
+            end
+
+            if (is_read || is_write) begin
+                data_memory_address_t address = is_read ? consumer_read_address[consumer] : consumer_write_address[consumer];
+                data_memory_address_t line_address = address / LINE_SIZE;
+                int set = int'(line_address % NUM_SETS);
+                int offset = int'(address % LINE_SIZE);
+                logic line_in_flight = 0;
+                logic line_being_written = 0;
+                int hit_way = -1;
+
+                for (int i = 0; i < NUM_MSHRS; i++) begin
+                    if (mshr_busy[i] && (mshr_busy_line_address[i] == line_address || (mshr_busy_evicting[i] && mshr_busy_evicted_line_address[i] == line_address))) begin
+                        line_in_flight = 1;
+                    end
+                end
+                for (int i = 0; i < NUM_WRITE_PORTS; i++) begin
+                    if (write_port_busy[i] && write_port_busy_line_address[i] == line_address) begin
+                        line_being_written = 1;
+                    end
+                end
+                for (int way = 0; way < ASSOCIATIVITY; way++) begin
+                    logic way_reserved = 0;
+                    for (int i = 0; i < NUM_MSHRS; i++) begin
+                        if (mshr_busy[i] && mshr_busy_set[i] == set && mshr_busy_way[i] == way) begin
+                            way_reserved = 1;
+                        end
+                    end
+                    for (int i = 0; i < num_dropped_lines; i++) begin
+                        if (dropped_set[i] == set && dropped_way[i] == way) begin
+                            way_reserved = 1;
+                        end
+                    end
+                    if (!way_reserved && line_valid[set][way] && line_tag[set][way] == line_address) begin
+                        hit_way = way;
+                    end
+                end
+
+                if (line_in_flight) begin
+                    // Wait for the MSHR that handles this line, this does not use up a lookup port
+                    if (!consumer_missed[consumer] && !is_atomic) begin
+                        consumer_missed[consumer] <= 1;
+                        num_misses = num_misses + 1;
+                    end
+                end else begin
+                    num_lookups = num_lookups + 1;
+                    last_consumer = consumer;
+
+                    if (is_atomic) begin
+                        // Memory performs the atomic, so it has to hold the latest data of the line and the line must not be
+                        // served from the cache afterwards
+                        logic line_stored = 0;
+                        for (int i = 0; i < num_stored_lines; i++) begin
+                            if (hit_way != -1 && stored_set[i] == set && stored_way[i] == hit_way) begin
+                                line_stored = 1;
+                            end
+                        end
+
+                        if (hit_way != -1 && line_dirty[set][hit_way]) begin
+                            // Write the dirty line back, the MSHR refills it afterwards and the atomic is looked up again
+                            int mshr = -1;
+                            for (int i = 0; i < NUM_MSHRS; i++) begin
+                                if (!mshr_busy[i]) begin
+                                    mshr = i;
+                                    break;
+                                end
+                            end
+
+                            if (!line_stored && mshr != -1) begin
+                                mshr_busy[mshr] = 1;
+                                mshr_busy_evicting[mshr] = 1;
+                                mshr_busy_line_address[mshr] = line_address;
+                                mshr_busy_evicted_line_address[mshr] = line_address;
+                                mshr_busy_set[mshr] = set;
+                                mshr_busy_way[mshr] = hit_way;
+
+                                mshr_state[mshr] <= MSHR_WRITEBACK;
+                                mshr_port_state[mshr] <= PORT_REQUESTING;
+                                mshr_line_address[mshr] <= line_address;
+                                mshr_evicted_line_address[mshr] <= line_address;
+                                mshr_set[mshr] <= set;
+                                mshr_way[mshr] <= hit_way;
+                                mshr_offset[mshr] <= 0;
+
+                                line_valid[set][hit_way] <= 0;
+
+                                mem_write_valid[mshr] <= 1;
+                                mem_write_address[mshr] <= line_address * LINE_SIZE;
+                                mem_write_data[mshr] <= line_data[set][hit_way][0];
+                            end
+                        end else if (!line_stored && !line_being_written) begin
+                            int write_port = -1;
+                            for (int i = 0; i < NUM_WRITE_PORTS; i++) begin
+                                if (!write_port_busy[i]) begin
+                                    write_port = i;
+                                    break;
+                                end
+                            end
+
+                            if (write_port != -1) begin
+                                write_port_busy[write_port] = 1;
+                                write_port_busy_line_address[write_port] = line_address;
+                                write_port_state[write_port] <= PORT_REQUESTING;
+                                write_port_consumer[write_port] <= consumer;
+                                write_port_atomic[write_port] <= 1;
+                                consumer_atomic_issued[consumer] <= 1;
+
+                                mem_read_valid[NUM_MSHRS + write_port] <= 1;
+                                mem_read_address[NUM_MSHRS + write_port] <= address;
+                                mem_read_atomic_op[NUM_MSHRS + write_port] <= consumer_read_atomic_op[consumer];
+                                mem_read_atomic_operand[NUM_MSHRS + write_port] <= consumer_read_atomic_operand[consumer];
+                                mem_read_atomic_compare[NUM_MSHRS + write_port] <= consumer_read_atomic_compare[consumer];
+
+                                if (hit_way != -1) begin
+                                    line_valid[set][hit_way] <= 0;
+                                    dropped_set[num_dropped_lines] = set;
+                                    dropped_way[num_dropped_lines] = hit_way;
+                                    num_dropped_lines = num_dropped_lines + 1;
+                                end
+                            end
+                        end
+                    end else if (is_read && hit_way != -1) begin
+                        // Serve this read and, when coalescing, every other pending read to the same line
+                        for (int i = 0; i < NUM_CONSUMERS; i++) begin
+                            if (i == consumer || (COALESCE == 1 && consumer_read_valid[i] && !consumer_read_ready[i] && !consumer_coalesced[i]
+                                    && consumer_read_atomic_op[i] == ATOMIC_NONE && consumer_read_address[i] / LINE_SIZE == line_address)) begin
+                                consumer_coalesced[i] = 1;
+                                consumer_read_ready[i] <= 1;
+                                consumer_read_data[i] <= line_data[set][hit_way][consumer_read_address[i] % LINE_SIZE];
+                                if (consumer_missed[i]) begin
+                                    consumer_missed[i] <= 0;
+                                end else begin
+                                    num_hits = num_hits + 1;
+                                end
+                            end
+                        end
+                    end else if (is_write && WRITE_BACK == 1 && hit_way != -1) begin
+                        // Merge this store and, when coalescing, every other pending store to the same line into the line
+                        for (int i = 0; i < NUM_CONSUMERS; i++) begin
+                            if (i == consumer || (COALESCE == 1 && consumer_write_valid[i] && !consumer_write_ready[i] && !consumer_coalesced[i]
+                                    && consumer_write_address[i] / LINE_SIZE == line_address)) begin
+                                consumer_coalesced[i] = 1;
+                                line_data[set][hit_way][consumer_write_address[i] % LINE_SIZE] <= consumer_write_data[i];
+                                consumer_write_ready[i] <= 1;
+                                if (consumer_missed[i]) begin
+                                    consumer_missed[i] <= 0;
+                                end else begin
+                                    num_hits = num_hits + 1;
+                                end
+                            end
+                        end
+                        line_dirty[set][hit_way] <= 1;
+                        stored_set[num_stored_lines] = set;
+                        stored_way[num_stored_lines] = hit_way;
+                        num_stored_lines = num_stored_lines + 1;
+                    end else if (is_write && WRITE_BACK == 0) begin
+                        // Write-through, update the line on a hit and forward the store to memory
+                        int write_port = -1;
+                        for (int i = 0; i < NUM_WRITE_PORTS; i++) begin
+                            if (!write_port_busy[i]) begin
+                                write_port = i;
+                                break;
+                            end
+                        end
+
+                        if (write_port != -1) begin
+                            write_port_busy[write_port] = 1;
+                            write_port_busy_line_address[write_port] = line_address;
+                            write_port_state[write_port] <= PORT_REQUESTING;
+                            write_port_consumer[write_port] <= consumer;
+                            write_port_atomic[write_port] <= 0;
+                            consumer_write_issued[consumer] <= 1;
+
+                            mem_write_valid[NUM_MSHRS + write_port] <= 1;
+                            mem_write_address[NUM_MSHRS + write_port] <= address;
+                            mem_write_data[NUM_MSHRS + write_port] <= consumer_write_data[consumer];
+
+                            if (hit_way != -1) begin
+                                line_data[set][hit_way][offset] <= consumer_write_data[consumer];
+                            end
+                            if (consumer_missed[consumer]) begin
+                                consumer_missed[consumer] <= 0;
+                            end else if (hit_way != -1) begin
+                                num_hits = num_hits + 1;
+                            end else begin
+                                num_misses = num_misses + 1;
+                            end
+                        end
+                    end else begin
+                        // Line miss, allocate an MSHR unless a store to this line is still on its way to memory
+                        int mshr = -1;
+                        int victim_way = -1;
+
+                        for (int i = 0; i < NUM_MSHRS; i++) begin
+                            if (!mshr_busy[i]) begin
+                                mshr = i;
+                                break;
+                            end
+                        end
+
+                        // Skip ways that are being filled or were just written by a store hit
+                        for (int w = 0; w < ASSOCIATIVITY; w++) begin
+                            int way = (replacement_way[set] + w) % ASSOCIATIVITY;
+                            logic way_reserved = 0;
+                            for (int i = 0; i < NUM_MSHRS; i++) begin
+                                if (mshr_busy[i] && mshr_busy_set[i] == set && mshr_busy_way[i] == way) begin
+                                    way_reserved = 1;
+                                end
+                            end
+                            for (int i = 0; i < num_stored_lines; i++) begin
+                                if (stored_set[i] == set && stored_way[i] == way) begin
+                                    way_reserved = 1;
+                                end
+                            end
+                            if (!way_reserved) begin
+                                victim_way = way;
+                                break;
+                            end
+                        end
+
+                        if (!line_being_written && mshr != -1 && victim_way != -1) begin
+                            logic evict_dirty = WRITE_BACK == 1 && line_valid[set][victim_way] && line_dirty[set][victim_way];
+
+                            mshr_busy[mshr] = 1;
+                            mshr_busy_evicting[mshr] = evict_dirty;
+                            mshr_busy_line_address[mshr] = line_address;
+                            mshr_busy_evicted_line_address[mshr] = line_tag[set][victim_way];
+                            mshr_busy_set[mshr] = set;
+                            mshr_busy_way[mshr] = victim_way;
+
+                            mshr_state[mshr] <= evict_dirty ? MSHR_WRITEBACK : MSHR_FILL;
+                            mshr_port_state[mshr] <= PORT_REQUESTING;
+                            mshr_line_address[mshr] <= line_address;
+                            mshr_evicted_line_address[mshr] <= line_tag[set][victim_way];
+                            mshr_set[mshr] <= set;
+                            mshr_way[mshr] <= victim_way;
+                            mshr_offset[mshr] <= 0;
+
+                            line_valid[set][victim_way] <= 0;
+                            replacement_way[set] <= (victim_way + 1) % ASSOCIATIVITY;
+
+                            if (evict_dirty) begin
+                                mem_write_valid[mshr] <= 1;
+                                mem_write_address[mshr] <= line_tag[set][victim_way] * LINE_SIZE;
+                                mem_write_data[mshr] <= line_data[set][victim_way][0];
+                            end else begin
+                                mem_read_valid[mshr] <= 1;
+                                mem_read_address[mshr] <= line_address * LINE_SIZE;
+                            end
+                        end
+
+                        if (!consumer_missed[consumer]) begin
+                            consumer_missed[consumer] <= 1;
+                            num_misses = num_misses + 1;
+                        end
+                    end
+                end
+            end
+        end
+
+        if (last_consumer != -1) begin
+            next_consumer <= (last_consumer + 1) % NUM_CONSUMERS;
+        end
+        hits <= hits + num_hits;
+        misses <= misses + num_misses;
+        transactions <= transactions + num_lookups;
+
+        // Flush dirty lines one word per cycle, then wait for all memory ports to go idle
+        if (!flush) begin
+            flushed <= 0;
+            flush_line <= 0;
+            flush_offset <= 0;
+        end else if (!flushed) begin
+            if (WRITE_BACK == 0 || flush_line == NUM_LINES) begin
+                logic ports_idle = 1;
+                for (int i = 0; i < NUM_MSHRS; i++) begin
+                    if (mshr_state[i] != MSHR_IDLE) begin
+                        ports_idle = 0;
+                    end
+                end
+                for (int i = 0; i < NUM_WRITE_PORTS; i++) begin
+                    if (write_port_state[i] != PORT_IDLE) begin
+                        ports_idle = 0;
+                    end
+                end
+                if (ports_idle) begin
+                    flushed <= 1;
+                end
+            end else begin
+                int set = flush_line / ASSOCIATIVITY;
+                int way = flush_line % ASSOCIATIVITY;
+                if (!line_valid[set][way] || !line_dirty[set][way]) begin
+                    flush_line <= flush_line + 1;
+                end else begin
+                    int write_port = -1;
+                    for (int i = 0; i < NUM_WRITE_PORTS; i++) begin
+                        if (!write_port_busy[i]) begin
+                            write_port = i;
+                            break;
+                        end
+                    end
+
+                    if (write_port != -1) begin
+                        write_port_state[write_port] <= PORT_REQUESTING;
+                        write_port_consumer[write_port] <= -1;
+                        write_port_atomic[write_port] <= 0;
+                        mem_write_valid[NUM_MSHRS + write_port] <= 1;
+                        mem_write_address[NUM_MSHRS + write_port] <= line_tag[set][way] * LINE_SIZE + data_memory_address_t'(flush_offset);
+                        mem_write_data[NUM_MSHRS + write_port] <= line_data[set][way][flush_offset];
+
+                        if (flush_offset == LINE_SIZE - 1) begin
+                            line_dirty[set][way] <= 0;
+                            flush_offset <= 0;
+                            flush_line <= flush_line + 1;
+                        end else begin
+                            flush_offset <= flush_offset + 1;
+                        end
+                    end
+                end
+            end
+        end
+    end
+end
+
+endmodule
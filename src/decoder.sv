@@ -7,12 +7,15 @@ module decoder(
     input wire clk,
     input wire reset,
     input warp_state_t warp_state,
+    input fetcher_state_t fetcher_state,
 
     input instruction_t instruction,
 
     output reg decoded_reg_write_enable,
     output reg decoded_mem_write_enable,
     output reg decoded_mem_read_enable,
+    output reg decoded_shared_write_enable,
+    output reg decoded_shared_read_enable,
     output reg decoded_branch,
     output reg_input_mux_t decoded_reg_input_mux,
     output reg decoded_scalar_instruction,
@@ -20,9 +23,14 @@ module decoder(
     output reg [4:0] decoded_rd_address,
     output reg [4:0] decoded_rs1_address,
     output reg [4:0] decoded_rs2_address,
+    output reg [4:0] decoded_rs3_address,           // Third source, read by AMOCAS for its compare value and by MAC and DOT4 for the accumulator
     output alu_instruction_t decoded_alu_instruction,
+    output atomic_op_t decoded_atomic_op,
+    output lane_op_t decoded_lane_op,
+    output mask_op_t decoded_mask_op,
 
-    output reg decoded_halt
+    output reg decoded_halt,
+    output reg decoded_barrier
 );
     // Extract fields from instruction
     wire         scalar = instruction[6];
@@ -33,6 +41,7 @@ module decoder(
     wire [4:0]   rs1    = instruction[19:15];
     wire [4:0]   rs2    = instruction[24:20];
     wire [6:0]   funct7 = instruction[31:25];
+    wire [4:0]   funct5 = instruction[31:27];
     wire [11:0]  imm_i  = instruction[31:20];
     wire [11:0]  imm_s  = {instruction[31:25], instruction[11:7]};
     wire [12:0]  imm_b  = {instruction[31], instruction[7], instruction[30:25], instruction[11:8], 1'b0};
@@ -45,16 +54,24 @@ module decoder(
             decoded_reg_write_enable <= 0;
             decoded_mem_write_enable <= 0;
             decoded_mem_read_enable <= 0;
+            decoded_shared_write_enable <= 0;
+            decoded_shared_read_enable <= 0;
             decoded_branch <= 0;
             decoded_reg_input_mux <= ALU_OUT;
             decoded_immediate <= {`DATA_WIDTH{1'b0}};
             decoded_rd_address <= 5'b0;
             decoded_rs1_address <= 5'b0;
             decoded_rs2_address <= 5'b0;
+            decoded_rs3_address <= 5'b0;
             decoded_alu_instruction <= ADDI;
+            decoded_atomic_op <= ATOMIC_NONE;
+            decoded_lane_op <= LANE_NONE;
+            decoded_mask_op <= MASK_NONE;
             decoded_halt <= 0;
+            decoded_barrier <= 0;
             decoded_scalar_instruction <= 0;
-        end else if (warp_state == WARP_DECODE) begin
+        end else if (warp_state == WARP_FETCH && fetcher_state == FETCHER_DONE) begin
+            // Decode in the cycle the fetched instruction is handed over, so the warp can go straight to WARP_REQUEST
             // Default assignments for new decode
             decoded_reg_write_enable <= 0;
             decoded_reg_input_mux <= ALU_OUT;
@@ -62,15 +79,44 @@ module decoder(
             decoded_rd_address <= 5'b0;
             decoded_rs1_address <= 5'b0;
             decoded_rs2_address <= 5'b0;
+            decoded_rs3_address <= 5'b0;
             decoded_alu_instruction <= ADDI;
+            decoded_atomic_op <= ATOMIC_NONE;
+            decoded_lane_op <= LANE_NONE;
+            decoded_mask_op <= MASK_NONE;
             decoded_mem_read_enable <= 0;
             decoded_mem_write_enable <= 0;
+            decoded_shared_read_enable <= 0;
+            decoded_shared_write_enable <= 0;
             decoded_branch <= 0;
             decoded_halt <= 0;
+            decoded_barrier <= 0;
             decoded_scalar_instruction <= scalar;
 
             if (opcode == `OPCODE_HALT) begin
                 decoded_halt <= 1;
+            end else if (opcode == `OPCODE_BAR) begin
+                decoded_barrier <= 1;
+            end else if (opcode == `OPCODE_SPLIT) begin
+                // The mask stack instructions read s1 and the predicate, the new mask is written back to s1
+                decoded_rd_address <= 5'd1;
+                decoded_rs1_address <= 5'd1;
+                decoded_rs2_address <= rs1;
+                decoded_immediate <= sign_extend(imm_i);
+                decoded_reg_write_enable <= 1;
+                decoded_reg_input_mux <= VECTOR_TO_SCALAR;
+                decoded_mask_op <= MASK_SPLIT;
+            end else if (opcode == `OPCODE_ELSE) begin
+                decoded_rd_address <= 5'd1;
+                decoded_immediate <= sign_extend(imm_i);
+                decoded_reg_write_enable <= 1;
+                decoded_reg_input_mux <= VECTOR_TO_SCALAR;
+                decoded_mask_op <= MASK_ELSE;
+            end else if (opcode == `OPCODE_JOIN) begin
+                decoded_rd_address <= 5'd1;
+                decoded_reg_write_enable <= 1;
+                decoded_reg_input_mux <= VECTOR_TO_SCALAR;
+                decoded_mask_op <= MASK_JOIN;
             end else if (opcode == `OPCODE_SX_SLT) begin
                 decoded_scalar_instruction <= 0; // This is a vector-scalar instruction
                 decoded_rd_address <= rd;
@@ -87,7 +133,66 @@ module decoder(
                 decoded_reg_write_enable <= 1;
                 decoded_reg_input_mux <= VECTOR_TO_SCALAR;
                 decoded_alu_instruction <= SLTI;                // not implemented yet
-        end else if (opcode == `OPCODE_B) begin
+            end else if (opcode == `OPCODE_SX_RED) begin
+                // Warp-wide reduction into a scalar register, a vector-scalar instruction like SX_SLT
+                decoded_scalar_instruction <= 0;
+                decoded_rd_address <= rd;
+                decoded_rs1_address <= rs1;
+                decoded_reg_write_enable <= 1;
+                decoded_reg_input_mux <= VECTOR_TO_SCALAR;
+
+                unique case (funct3)
+                    `FUNCT3_REDADD: decoded_lane_op <= LANE_REDUCE_ADD;
+                    `FUNCT3_REDMIN: decoded_lane_op <= LANE_REDUCE_MIN;
+                    `FUNCT3_REDMAX: decoded_lane_op <= LANE_REDUCE_MAX;
+                    `FUNCT3_REDOR: decoded_lane_op <= LANE_REDUCE_OR;
+                    `FUNCT3_REDAND: decoded_lane_op <= LANE_REDUCE_AND;
+                    default: $error("Invalid SX_RED instruction with funct3 %b", funct3);
+                endcase
+            end else if (opcode == `OPCODE_SHFL) begin
+                // Lane shuffle, a vector instruction despite its opcode
+                decoded_scalar_instruction <= 0;
+                decoded_rd_address <= rd;
+                decoded_rs1_address <= rs1;
+                decoded_rs2_address <= rs2;
+                decoded_reg_write_enable <= 1;
+                decoded_reg_input_mux <= SHUFFLE_OUT;
+                decoded_lane_op <= LANE_SHUFFLE;
+            end else if (opcode == `OPCODE_LWS) begin
+                // Shared memory load, a vector instruction despite its opcode
+                decoded_scalar_instruction <= 0;
+                decoded_rd_address <= rd;
+                decoded_rs1_address <= rs1;
+                decoded_reg_write_enable <= 1;
+                decoded_reg_input_mux <= SHARED_MEMORY_OUT;
+                decoded_immediate <= sign_extend(imm_i);
+                decoded_shared_read_enable <= 1;
+            end else if (opcode == `OPCODE_SWS) begin
+                // Shared memory store, a vector instruction despite its opcode
+                decoded_scalar_instruction <= 0;
+                decoded_rs1_address <= rs1;
+                decoded_rs2_address <= rs2;
+                decoded_immediate <= sign_extend(imm_s);
+                decoded_shared_write_enable <= 1;
+            end else if (opcode == `OPCODE_AMO) begin
+                // Atomic memory operation, a load whose request also carries the operation and its operands
+                decoded_rd_address <= rd;
+                decoded_rs1_address <= rs1;
+                decoded_rs2_address <= rs2;
+                decoded_rs3_address <= rd;
+                decoded_reg_write_enable <= 1;
+                decoded_reg_input_mux <= LSU_OUT;
+                decoded_mem_read_enable <= 1;
+
+                unique case (funct5)
+                    `FUNCT5_AMOADD: decoded_atomic_op <= ATOMIC_ADD;
+                    `FUNCT5_AMOSWAP: decoded_atomic_op <= ATOMIC_SWAP;
+                    `FUNCT5_AMOCAS: decoded_atomic_op <= ATOMIC_CAS;
+                    `FUNCT5_AMOMIN: decoded_atomic_op <= ATOMIC_MIN;
+                    `FUNCT5_AMOMAX: decoded_atomic_op <= ATOMIC_MAX;
+                    default: $error("Invalid AMO instruction with funct5 %b", funct5);
+                endcase
+            end else if (opcode == `OPCODE_B) begin
                 // Branch instructions (e.g., BEQ, BNE)
                 decoded_rs1_address <= rs1;
                 decoded_rs2_address <= rs2;
@@ -129,30 +234,48 @@ module decoder(
                         decoded_reg_input_mux <= ALU_OUT;
 
                         // Determine the ALU instruction
-                        unique case (funct3)
-                            3'b000: begin
-                                if (funct7 == 7'b0000000)
-                                    decoded_alu_instruction <= ADD;
-                                else if (funct7 == 7'b0100000)
-                                    decoded_alu_instruction <= SUB;
-                                else
-                                    $error("Invalid R-type instruction with funct7 %b", funct7);
-                            end
-                            3'b001: decoded_alu_instruction <= SLL;
-                            3'b010: decoded_alu_instruction <= SLT;
-                            3'b100: decoded_alu_instruction <= XOR;
-                            3'b101: begin
-                                if (funct7 == 7'b0000000)
-                                    decoded_alu_instruction <= SRL;
-                                else if (funct7 == 7'b0100000)
-                                    decoded_alu_instruction <= SRA;
-                                else
-                                    $error("Invalid R-type instruction with funct7 %b", funct7);
-                            end
-                            3'b110: decoded_alu_instruction <= OR;
-                            3'b111: decoded_alu_instruction <= AND;
-                            default: $error("Invalid R-type instruction with funct3 %b", funct3);
-                        endcase
+                        if (funct7 == `FUNCT7_MAC) begin
+                            // The accumulator is read through the third source port
+                            decoded_rs3_address <= rd;
+                            unique case (funct3)
+                                `FUNCT3_MAC: decoded_alu_instruction <= MAC;
+                                `FUNCT3_DOT4: decoded_alu_instruction <= DOT4;
+                                default: $error("Invalid multiply-accumulate instruction with funct3 %b", funct3);
+                            endcase
+                        end else if (funct7 == `FUNCT7_MULDIV) begin
+                            unique case (funct3)
+                                3'b000: decoded_alu_instruction <= MUL;
+                                3'b001: decoded_alu_instruction <= MULH;
+                                3'b100: decoded_alu_instruction <= DIV;
+                                3'b110: decoded_alu_instruction <= REM;
+                                default: $error("Invalid multiply or divide instruction with funct3 %b", funct3);
+                            endcase
+                        end else begin
+                            unique case (funct3)
+                                3'b000: begin
+                                    if (funct7 == 7'b0000000)
+                                        decoded_alu_instruction <= ADD;
+                                    else if (funct7 == 7'b0100000)
+                                        decoded_alu_instruction <= SUB;
+                                    else
+                                        $error("Invalid R-type instruction with funct7 %b", funct7);
+                                end
+                                3'b001: decoded_alu_instruction <= SLL;
+                                3'b010: decoded_alu_instruction <= SLT;
+                                3'b100: decoded_alu_instruction <= XOR;
+                                3'b101: begin
+                                    if (funct7 == 7'b0000000)
+                                        decoded_alu_instruction <= SRL;
+                                    else if (funct7 == 7'b0100000)
+                                        decoded_alu_instruction <= SRA;
+                                    else
+                                        $error("Invalid R-type instruction with funct7 %b", funct7);
+                                end
+                                3'b110: decoded_alu_instruction <= OR;
+                                3'b111: decoded_alu_instruction <= AND;
+                                default: $error("Invalid R-type instruction with funct3 %b", funct3);
+                            endcase
+                        end
                     end
                     `OPCODE_I: begin
                         // Vector I-type instructions
@@ -3,8 +3,17 @@
 
 `include "common.sv"
 
+// DISPATCHER
+// > Hands out the blocks of a kernel to block slots, each core has BLOCKS_PER_CORE of them
+// > Every block takes num_warps_per_block consecutive warps of its core, so a core holds as many blocks at once as its
+//   warps allow (up to BLOCKS_PER_CORE)
+// > A slot whose block finished is reset on its own and receives the next block, the other blocks of the core keep running
+// > With BLOCK_RELAUNCH the next block is handed to the slot in the cycle the previous one finished, without resetting it
 module dispatcher #(
-    parameter int NUM_CORES                 // Number of cores to include in this GPU
+    parameter int NUM_CORES,                // Number of cores to include in this GPU
+    parameter int WARPS_PER_CORE = 2,       // Number of warps in each core
+    parameter int BLOCKS_PER_CORE = 2,      // Maximum number of blocks running on a core at once
+    parameter int BLOCK_RELAUNCH = 1        // Whether a finished slot takes the next block directly instead of going through a reset
 ) (
     input wire clk,
     input wire reset,
@@ -14,20 +23,38 @@ module dispatcher #(
     input kernel_config_t kernel_config,
 
     // Core States
-    input reg [NUM_CORES-1:0] core_done,
-    output reg [NUM_CORES-1:0] core_start,
     output reg [NUM_CORES-1:0] core_reset,
-    output data_t core_block_id [NUM_CORES],
+
+    // Block Slot States, slot j of core i is at index i * BLOCKS_PER_CORE + j
+    input reg [NUM_CORES*BLOCKS_PER_CORE-1:0] block_done,
+    output reg [NUM_CORES*BLOCKS_PER_CORE-1:0] block_start,
+    output reg [NUM_CORES*BLOCKS_PER_CORE-1:0] block_reset,
+    output reg [NUM_CORES*BLOCKS_PER_CORE-1:0] block_relaunch,  // The slot restarts its warps on the new block_id
+    output data_t block_id [NUM_CORES*BLOCKS_PER_CORE],
+    output data_t resident_blocks,          // Number of slots per core that fit into the warps of the core
 
     // Kernel Execution
     output reg done
 );
 
+localparam int NUM_SLOTS = NUM_CORES * BLOCKS_PER_CORE;
+
 data_t total_blocks = kernel_config.num_blocks;
 
 data_t blocks_done;
 data_t blocks_dispatched; // How many blocks have been sent to cores?
 
+// Only the first resident_blocks slots of each core receive blocks
+always_comb begin
+    resident_blocks = kernel_config.num_warps_per_block == 0 ? 1 : WARPS_PER_CORE / kernel_config.num_warps_per_block;
+    if (resident_blocks > BLOCKS_PER_CORE) begin
+        resident_blocks = BLOCKS_PER_CORE;
+    end
+    if (resident_blocks == 0) begin
+        resident_blocks = 1;
+    end
+end
+
 logic start_execution; // EDA: Unimportant hack used because of EDA tooling
 
 always @(posedge clk) begin
@@ -38,11 +65,17 @@ always @(posedge clk) begin
         start_execution <= 0;
 
         for (int i = 0; i < NUM_CORES; i++) begin
-            core_start[i] <= 0;
             core_reset[i] <= 1;
-            core_block_id[i] <= 0;
+        end
+        for (int i = 0; i < NUM_SLOTS; i++) begin
+            block_start[i] <= 0;
+            block_reset[i] <= 1;
+            block_relaunch[i] <= 0;
+            block_id[i] <= 0;
         end
     end else if (start) begin
+        data_t num_blocks_done = blocks_done;
+
         // EDA: Indirect way to get @(posedge start) without driving from 2 different clocks
         if (!start_execution) begin
             $display("Dispatcher: Start execution of %0d block(s)", total_blocks);
@@ -50,6 +83,13 @@ always @(posedge clk) begin
             for (int i = 0; i < NUM_CORES; i++) begin
                 core_reset[i] <= 1;
             end
+            for (int i = 0; i < NUM_SLOTS; i++) begin
+                block_reset[i] <= 1;
+            end
+        end else begin
+            for (int i = 0; i < NUM_CORES; i++) begin
+                core_reset[i] <= 0;
+            end
         end
 
         // If the last block has finished processing, mark this kernel as done executing
@@ -58,30 +98,45 @@ always @(posedge clk) begin
             done <= 1;
         end
 
-        for (int i = 0; i < NUM_CORES; i++) begin
-            if (core_reset[i]) begin
-                core_reset[i] <= 0;
+        for (int i = 0; i < NUM_SLOTS; i++) begin
+            if (block_reset[i]) begin
+                block_reset[i] <= 0;
 
-                // If this core was just reset, check if there are more blocks to be dispatched
-                if (blocks_dispatched < total_blocks) begin
-                    $display("Dispatcher: Dispatching block %d to core %d", blocks_dispatched, i);
-                    core_start[i] <= 1;
-                    core_block_id[i] <= blocks_dispatched;
+                // If this slot was just reset, check if there are more blocks to be dispatched
+                // Slots beyond the warps of the core stay empty
+                if (blocks_dispatched < total_blocks && i % BLOCKS_PER_CORE < resident_blocks) begin
+                    $display("Dispatcher: Dispatching block %d to core %d", blocks_dispatched, i / BLOCKS_PER_CORE);
+                    block_start[i] <= 1;
+                    block_id[i] <= blocks_dispatched;
 
                     blocks_dispatched = blocks_dispatched + 1;
                 end
             end
         end
 
-        for (int i = 0; i < NUM_CORES; i++) begin
-            if (core_start[i] && core_done[i]) begin
-                // If a core just finished executing it's current block, reset it
-                $display("Dispatcher: Core %d finished block %d", i, core_block_id[i]);
-                core_reset[i] <= 1;
-                core_start[i] <= 0;
-                blocks_done <= blocks_done + 1;
+        for (int i = 0; i < NUM_SLOTS; i++) begin
+            block_relaunch[i] <= 0;
+
+            // The slot still reports the previous block as done in the cycle it relaunches
+            if (block_start[i] && block_done[i] && !block_relaunch[i]) begin
+                $display("Dispatcher: Core %d finished block %d", i / BLOCKS_PER_CORE, block_id[i]);
+                num_blocks_done = num_blocks_done + 1;
+
+                if (BLOCK_RELAUNCH == 1 && blocks_dispatched < total_blocks) begin
+                    // Relaunch the slot with the next block right away
+                    $display("Dispatcher: Relaunching core %d with block %d", i / BLOCKS_PER_CORE, blocks_dispatched);
+                    block_relaunch[i] <= 1;
+                    block_id[i] <= blocks_dispatched;
+
+                    blocks_dispatched = blocks_dispatched + 1;
+                end else begin
+                    // If a slot just finished executing its current block, reset it
+                    block_reset[i] <= 1;
+                    block_start[i] <= 0;
+                end
             end
         end
+        blocks_done <= num_blocks_done;
     end
 end
 endmodule
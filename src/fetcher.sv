@@ -3,7 +3,9 @@
 
 `include "common.sv"
 
-module fetcher (
+module fetcher#(
+    parameter int PREFETCH_DEPTH = 4    // Number of sequential instructions buffered ahead of the pc (0 fetches on demand only)
+    )(
     input wire clk,
     input wire reset,
 
@@ -21,30 +23,87 @@ module fetcher (
     output instruction_t instruction
 );
 
+localparam int BUFFER_SIZE = PREFETCH_DEPTH > 0 ? PREFETCH_DEPTH : 1;
+
+// Instructions at buffer_base, buffer_base + 1, ... buffer_base + buffer_count - 1
+instruction_t buffer_data [BUFFER_SIZE];
+instruction_memory_address_t buffer_base;
+int buffer_count;
+
+cache_port_state_t port_state;
+
+// Per cycle view of the buffer, updated in order: flush, response, hand over, next request
+instruction_t next_data [BUFFER_SIZE];
+instruction_memory_address_t next_base;
+int next_count;
+logic warp_running;
+
 always @(posedge clk) begin
     if (reset) begin
         fetcher_state <= FETCHER_IDLE;
         instruction_mem_read_valid <= 0;
         instruction_mem_read_address <= 0;
         instruction <= {`INSTRUCTION_WIDTH{1'b0}};
+        buffer_base <= 0;
+        buffer_count <= 0;
+        port_state <= PORT_IDLE;
     end else begin
-        case (fetcher_state)
-            FETCHER_IDLE: begin
-                if (warp_state == WARP_FETCH) begin
-                    fetcher_state <= FETCHER_FETCHING;
-                    instruction_mem_read_valid <= 1;
-                    instruction_mem_read_address <= pc;
-                end
-            end
-            FETCHER_FETCHING: begin
+        next_data = buffer_data;
+        next_base = buffer_base;
+        next_count = buffer_count;
+        warp_running = warp_state != WARP_IDLE && warp_state != WARP_DONE;
+
+        // A warp that asks for an address other than the head of the buffer took a jump or a branch
+        // (or started a new kernel), so everything buffered so far is stale
+        if (!warp_running || (warp_state == WARP_FETCH && fetcher_state != FETCHER_DONE && buffer_base != pc)) begin
+            next_base = pc;
+            next_count = 0;
+        end
+
+        case (port_state)
+            PORT_IDLE: begin end
+            PORT_REQUESTING: begin
                 if (instruction_mem_read_ready) begin
-                    fetcher_state <= FETCHER_DONE;
                     instruction_mem_read_valid <= 0;
-                    instruction <= instruction_mem_read_data;
+                    port_state <= PORT_RELEASING;
+                    // Responses to requests sent before a flush are dropped
+                    if (instruction_mem_read_address == next_base + next_count && next_count < BUFFER_SIZE) begin
+                        next_data[next_count] = instruction_mem_read_data;
+                        next_count = next_count + 1;
+                    end
+                end
+            end
+            PORT_RELEASING: begin
+                // Wait for the memory controller to release the channel before the next request
+                if (!instruction_mem_read_ready) begin
+                    port_state <= PORT_IDLE;
+                end
+            end
+            default: begin
+                $error("Invalid fetcher port state");
+            end
+        endcase
+
+        case (fetcher_state)
+            FETCHER_IDLE, FETCHER_FETCHING: begin
+                if (warp_state == WARP_FETCH) begin
+                    if (next_count > 0) begin
+                        // The head of the buffer is the instruction at pc, hand it over and shift the rest down
+                        fetcher_state <= FETCHER_DONE;
+                        instruction <= next_data[0];
+                        for (int i = 0; i < BUFFER_SIZE - 1; i = i + 1) begin
+                            next_data[i] = next_data[i + 1];
+                        end
+                        next_base = next_base + 1;
+                        next_count = next_count - 1;
+                    end else begin
+                        fetcher_state <= FETCHER_FETCHING;
+                    end
                 end
             end
             FETCHER_DONE: begin
-                if (warp_state == WARP_DECODE) begin
+                // The instruction is decoded as soon as the fetch completes, then the warp leaves WARP_FETCH
+                if (warp_state != WARP_FETCH) begin
                     fetcher_state <= FETCHER_IDLE;
                 end
             end
@@ -52,6 +111,20 @@ always @(posedge clk) begin
                 $error("Invalid fetcher state");
             end
         endcase
+
+        // Keep the buffer filled with the instructions following pc while the warp executes,
+        // without prefetching only fetch once the warp asks for its next instruction
+        if (port_state == PORT_IDLE && warp_running && (PREFETCH_DEPTH > 0
+                ? next_count < PREFETCH_DEPTH
+                : (warp_state == WARP_FETCH && fetcher_state != FETCHER_DONE && next_count == 0))) begin
+            port_state <= PORT_REQUESTING;
+            instruction_mem_read_valid <= 1;
+            instruction_mem_read_address <= next_base + next_count;
+        end
+
+        buffer_data <= next_data;
+        buffer_base <= next_base;
+        buffer_count <= next_count;
     end
 end
 
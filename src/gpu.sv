@@ -8,7 +8,41 @@ module gpu #(
     parameter int INSTRUCTION_MEM_NUM_CHANNELS /*verilator public*/ = 8,     // Number of concurrent channels for sending requests to data memory
     parameter int NUM_CORES /*verilator public*/ = 2,                 // Number of cores to include in this GPU
     parameter int WARPS_PER_CORE /*verilator public*/ = 2,            // Number of warps to in each core
-    parameter int THREADS_PER_WARP /*verilator public*/ = 32          // Number of threads per warp (max 32)
+    parameter int BLOCKS_PER_CORE /*verilator public*/ = WARPS_PER_CORE, // Maximum number of blocks running on a core at once, as far as its warps allow
+    parameter int BLOCK_RELAUNCH /*verilator public*/ = 1,            // Whether a core starts its next block right away, only resetting pcs, warp states and x1 - x3
+    parameter int THREADS_PER_WARP /*verilator public*/ = 32,         // Number of threads per warp (max 32)
+    parameter int ICACHE_ENABLE /*verilator public*/ = 1,             // Whether each core has an instruction cache in front of its fetchers
+    parameter int ICACHE_SIZE /*verilator public*/ = 256,             // Number of instructions held by each instruction cache
+    parameter int ICACHE_LINE_SIZE /*verilator public*/ = 4,          // Number of instructions per instruction cache line
+    parameter int ICACHE_ASSOCIATIVITY /*verilator public*/ = 2,      // Number of ways per instruction cache set
+    parameter int DCACHE_ENABLE /*verilator public*/ = 1,             // Whether each core has an L1 data cache in front of its LSUs
+    parameter int DCACHE_SIZE /*verilator public*/ = 1024,            // Number of words held by each data cache
+    parameter int DCACHE_LINE_SIZE /*verilator public*/ = 4,          // Number of words per data cache line
+    parameter int DCACHE_ASSOCIATIVITY /*verilator public*/ = 2,      // Number of ways per data cache set
+    parameter int DCACHE_NUM_MSHRS /*verilator public*/ = 4,          // Number of outstanding line misses per data cache
+    parameter int DCACHE_NUM_WRITE_PORTS /*verilator public*/ = 4,    // Number of memory ports per data cache used by write-through stores and flushes
+    parameter int DCACHE_NUM_LOOKUP_PORTS /*verilator public*/ = 4,   // Number of requests each data cache looks up per cycle
+    parameter int DCACHE_WRITE_BACK /*verilator public*/ = 0,         // 0 = write-through, 1 = write-back (dirty lines are flushed at the end of the kernel)
+    parameter int DCACHE_COALESCE /*verilator public*/ = 1,           // Whether the data caches serve all requests of a warp to the same line with one lookup
+    parameter int UNIFORM_LOAD_BROADCAST /*verilator public*/ = 1,    // Whether warp loads from a single address are sent once and broadcast to all lanes
+    parameter int WARP_SWITCH_ON_STALL /*verilator public*/ = 1,      // Whether cores run other warps while the current one waits on memory or on a fetch
+    parameter int PREFETCH_DEPTH /*verilator public*/ = 4,            // Number of sequential instructions each fetcher buffers ahead of its warp (0 = fetch on demand)
+    parameter int FETCH_MERGE /*verilator public*/ = 1,               // Whether program memory reads of the same address share one request
+    parameter int REGISTER_SCOREBOARD /*verilator public*/ = 1,       // Whether warps keep issuing independent instructions while their loads are in flight
+    parameter int WRITE_BUFFER_DEPTH /*verilator public*/ = 64,       // Number of posted stores each core buffers before they reach memory (0 = stores wait for memory)
+    parameter int WRITE_COMBINE_WINDOW /*verilator public*/ = 16,     // Number of cycles a posted store waits to be combined with later stores to the same word
+    parameter int SHARED_MEMORY_SIZE /*verilator public*/ = 1024,     // Number of scratchpad words per core, split evenly between its resident blocks
+    parameter int SHARED_MEMORY_BANKS /*verilator public*/ = 32,      // Number of scratchpad banks per core, lanes accessing different words of a bank are served one after another
+    parameter int MASK_STACK_DEPTH /*verilator public*/ = 8,          // Number of nested divergent regions (split ... join) each warp can be in
+    parameter int ZERO_MASK_SKIP /*verilator public*/ = 1,            // Whether vector instructions of a warp without active lanes skip operand reads, ALUs and LSUs
+    parameter int MUL_LATENCY /*verilator public*/ = 2,               // Number of cycles a warp waits for the multipliers of the ALUs (MUL, MULH, MAC, DOT4)
+    parameter int DIV_LATENCY /*verilator public*/ = 8,               // Number of cycles a warp waits for the dividers of the ALUs (DIV, REM)
+    parameter int SCHEDULER_POLICY /*verilator public*/ = `SCHEDULER_LOOSE_ROUND_ROBIN, // How each core chooses the next warp to execute
+    parameter int SCHEDULER_ACTIVE_WARPS /*verilator public*/ = (WARPS_PER_CORE + 1) / 2, // Two-level scheduling: size of the active warp set
+    parameter int MEM_ARBITRATION_POLICY /*verilator public*/ = `ARBITRATION_ROUND_ROBIN, // How the memory controllers choose between pending consumers
+    parameter int MEM_MAX_OUTSTANDING /*verilator public*/ = 4,       // Number of requests each memory channel can have in flight
+    parameter int DATA_MEM_CHANNEL_MAPPING /*verilator public*/ = `CHANNEL_MAPPING_ANY, // How data memory requests are assigned to channels
+    parameter int DATA_MEM_INTERLEAVE_SHIFT /*verilator public*/ = 2  // Interleaved mapping: blocks of 2^shift words go to the same channel (one cache line by default)
 ) (
     input wire clk,
     input wire reset,
@@ -22,18 +56,48 @@ module gpu #(
     // Program Memory
     output wire [INSTRUCTION_MEM_NUM_CHANNELS-1:0] instruction_mem_read_valid,
     output instruction_memory_address_t instruction_mem_read_address [INSTRUCTION_MEM_NUM_CHANNELS],
+    output mem_tag_t instruction_mem_read_tag [INSTRUCTION_MEM_NUM_CHANNELS],
     input wire [INSTRUCTION_MEM_NUM_CHANNELS-1:0] instruction_mem_read_ready,
     input instruction_t instruction_mem_read_data [INSTRUCTION_MEM_NUM_CHANNELS],
+    input mem_tag_t instruction_mem_read_response_tag [INSTRUCTION_MEM_NUM_CHANNELS],
 
     // Data Memory
     output wire [DATA_MEM_NUM_CHANNELS-1:0] data_mem_read_valid,
     output data_memory_address_t data_mem_read_address [DATA_MEM_NUM_CHANNELS],
+    output mem_tag_t data_mem_read_tag [DATA_MEM_NUM_CHANNELS],
+    output atomic_op_t data_mem_read_atomic_op [DATA_MEM_NUM_CHANNELS],     // Memory updates the word and answers with its old value
+    output data_t data_mem_read_atomic_operand [DATA_MEM_NUM_CHANNELS],
+    output data_t data_mem_read_atomic_compare [DATA_MEM_NUM_CHANNELS],
     input wire [DATA_MEM_NUM_CHANNELS-1:0] data_mem_read_ready,
     input data_memory_address_t data_mem_read_data [DATA_MEM_NUM_CHANNELS],
+    input mem_tag_t data_mem_read_response_tag [DATA_MEM_NUM_CHANNELS],
     output wire [DATA_MEM_NUM_CHANNELS-1:0] data_mem_write_valid,
     output data_memory_address_t data_mem_write_address [DATA_MEM_NUM_CHANNELS],
     output data_t data_mem_write_data [DATA_MEM_NUM_CHANNELS],
-    input wire [DATA_MEM_NUM_CHANNELS-1:0] data_mem_write_ready
+    output mem_tag_t data_mem_write_tag [DATA_MEM_NUM_CHANNELS],
+    input wire [DATA_MEM_NUM_CHANNELS-1:0] data_mem_write_ready,
+    input mem_tag_t data_mem_write_response_tag [DATA_MEM_NUM_CHANNELS],
+
+    // Performance Counters
+    output data_t perf_fetch_stall_cycles,      // Sum over all cycles of the number of warps waiting on an instruction fetch
+    output data_t perf_barrier_wait_cycles,     // Sum over all cycles of the number of warps waiting at a barrier
+    output data_t perf_icache_hits,
+    output data_t perf_icache_misses,
+    output data_t perf_dcache_hits,
+    output data_t perf_dcache_misses,
+    output data_t perf_dcache_transactions,     // Coalescing efficiency is (perf_dcache_hits + perf_dcache_misses) / perf_dcache_transactions
+    output data_t perf_uniform_loads,           // Number of warp loads served by a single broadcast request
+    output data_t perf_scheduler_idle_cycles,   // Sum over all cores of the cycles in which the current warp could not make progress
+    output data_t perf_merged_fetches,          // Program memory reads served by the request of another fetcher or instruction cache
+    output data_t perf_posted_stores,           // Stores accepted by the write buffers
+    output data_t perf_drained_stores,          // Stores the write buffers sent to memory, write combining efficiency is perf_posted_stores / perf_drained_stores
+    output data_t perf_shared_memory_accesses,  // Warp instructions served by the scratchpads
+    output data_t perf_shared_memory_bank_conflicts, // Extra cycles the scratchpads spent on lanes accessing different words of the same bank
+    output data_t perf_zero_mask_skips,         // Vector instructions that only advanced the pc, as no lane of their warp was active
+
+    // Cycles each memory controller consumer spent waiting for a channel (data caches or LSUs, instruction caches or fetchers)
+    output data_t perf_data_mem_wait_cycles [DCACHE_ENABLE ? NUM_CORES * (DCACHE_NUM_MSHRS + DCACHE_NUM_WRITE_PORTS) : NUM_CORES * (THREADS_PER_WARP + 1)],
+    output data_t perf_instruction_mem_wait_cycles [ICACHE_ENABLE ? NUM_CORES : NUM_CORES * WARPS_PER_CORE]
 );
 
 kernel_config_t kernel_config_reg;
@@ -54,10 +118,22 @@ always @(posedge clk) begin
     end
 end
 
-logic [NUM_CORES-1:0] core_done;
-logic [NUM_CORES-1:0] core_start;
+logic dispatcher_done;
+logic [NUM_CORES-1:0] dcache_flushed;
+
+// The kernel is only done once the data caches wrote all dirty lines back to memory
+assign execution_done = dispatcher_done && (&dcache_flushed);
+
 logic [NUM_CORES-1:0] core_reset;
-data_t core_block_id [NUM_CORES];
+
+// Block slots, BLOCKS_PER_CORE per core
+localparam int NUM_BLOCK_SLOTS = NUM_CORES * BLOCKS_PER_CORE;
+logic [NUM_BLOCK_SLOTS-1:0] block_done;
+logic [NUM_BLOCK_SLOTS-1:0] block_start;
+logic [NUM_BLOCK_SLOTS-1:0] block_reset;
+logic [NUM_BLOCK_SLOTS-1:0] block_relaunch;
+data_t block_id [NUM_BLOCK_SLOTS];
+data_t resident_blocks;     // Number of slots per core in use for this kernel
 
 // LSU <> Data Memory Controller Channels
 localparam int NUM_LSUS_PER_CORE = THREADS_PER_WARP + 1;
@@ -68,10 +144,29 @@ lsu_size_t lsu_read_ready;
 lsu_size_t lsu_write_valid;
 lsu_size_t lsu_write_ready;
 data_memory_address_t lsu_read_address [NUM_LSUS];
+atomic_op_t lsu_read_atomic_op [NUM_LSUS];
+data_t lsu_read_atomic_operand [NUM_LSUS];
+data_t lsu_read_atomic_compare [NUM_LSUS];
 data_memory_address_t lsu_write_address [NUM_LSUS];
 data_t lsu_read_data [NUM_LSUS];
 data_t lsu_write_data [NUM_LSUS];
 
+// Data Cache <> Data Memory Controller Channels
+// Without data caches the LSUs are connected to the data memory controller directly
+localparam int NUM_DCACHE_PORTS = DCACHE_NUM_MSHRS + DCACHE_NUM_WRITE_PORTS;
+localparam int NUM_DATA_MEM_CONSUMERS = DCACHE_ENABLE ? NUM_CORES * NUM_DCACHE_PORTS : NUM_LSUS;
+logic [NUM_DATA_MEM_CONSUMERS-1:0] data_mem_consumer_read_valid;
+data_memory_address_t data_mem_consumer_read_address [NUM_DATA_MEM_CONSUMERS];
+atomic_op_t data_mem_consumer_read_atomic_op [NUM_DATA_MEM_CONSUMERS];
+data_t data_mem_consumer_read_atomic_operand [NUM_DATA_MEM_CONSUMERS];
+data_t data_mem_consumer_read_atomic_compare [NUM_DATA_MEM_CONSUMERS];
+logic [NUM_DATA_MEM_CONSUMERS-1:0] data_mem_consumer_read_ready;
+data_t data_mem_consumer_read_data [NUM_DATA_MEM_CONSUMERS];
+logic [NUM_DATA_MEM_CONSUMERS-1:0] data_mem_consumer_write_valid;
+data_memory_address_t data_mem_consumer_write_address [NUM_DATA_MEM_CONSUMERS];
+data_t data_mem_consumer_write_data [NUM_DATA_MEM_CONSUMERS];
+logic [NUM_DATA_MEM_CONSUMERS-1:0] data_mem_consumer_write_ready;
+
 // Fetcher <> Program Memory Controller Channels
 localparam NUM_FETCHERS = NUM_CORES * WARPS_PER_CORE;
 typedef logic [NUM_FETCHERS-1:0] fetcher_size_t;
@@ -80,8 +175,85 @@ instruction_memory_address_t fetcher_read_address [NUM_FETCHERS];
 fetcher_size_t fetcher_read_ready;
 instruction_t fetcher_read_data [NUM_FETCHERS];
 
+// Instruction Cache <> Program Memory Controller Channels
+// Without instruction caches the fetchers are connected to the program memory controller directly
+localparam int NUM_PROGRAM_MEM_CONSUMERS = ICACHE_ENABLE ? NUM_CORES : NUM_FETCHERS;
+logic [NUM_PROGRAM_MEM_CONSUMERS-1:0] program_mem_read_valid;
+instruction_memory_address_t program_mem_read_address [NUM_PROGRAM_MEM_CONSUMERS];
+logic [NUM_PROGRAM_MEM_CONSUMERS-1:0] program_mem_read_ready;
+instruction_t program_mem_read_data [NUM_PROGRAM_MEM_CONSUMERS];
+
+// Per core statistics
+data_t core_num_warps_fetching [NUM_CORES];
+data_t core_num_warps_at_barrier [NUM_CORES];
+logic [NUM_CORES-1:0] core_uniform_load_executed;
+logic [NUM_CORES-1:0] core_scheduler_idle;
+data_t core_posted_stores [NUM_CORES];
+data_t core_drained_stores [NUM_CORES];
+logic [NUM_CORES-1:0] core_shared_memory_access;
+logic [NUM_CORES-1:0] core_shared_memory_bank_conflict;
+logic [NUM_CORES-1:0] core_zero_mask_skipped;
+data_t core_icache_hits [NUM_CORES];
+data_t core_icache_misses [NUM_CORES];
+data_t core_dcache_hits [NUM_CORES];
+data_t core_dcache_misses [NUM_CORES];
+data_t core_dcache_transactions [NUM_CORES];
+
+// Performance counters are only cleared by the global reset, so they keep counting across blocks
+always @(posedge clk) begin
+    if (reset) begin
+        perf_fetch_stall_cycles <= 0;
+        perf_barrier_wait_cycles <= 0;
+        perf_uniform_loads <= 0;
+        perf_scheduler_idle_cycles <= 0;
+        perf_posted_stores <= 0;
+        perf_drained_stores <= 0;
+        perf_shared_memory_accesses <= 0;
+        perf_shared_memory_bank_conflicts <= 0;
+        perf_zero_mask_skips <= 0;
+    end else begin
+        data_t num_warps_fetching = 0;
+        data_t num_warps_at_barrier = 0;
+        data_t num_posted_stores = 0;
+        data_t num_drained_stores = 0;
+        for (int i = 0; i < NUM_CORES; i = i + 1) begin
+            num_warps_fetching = num_warps_fetching + core_num_warps_fetching[i];
+            num_warps_at_barrier = num_warps_at_barrier + core_num_warps_at_barrier[i];
+            num_posted_stores = num_posted_stores + core_posted_stores[i];
+            num_drained_stores = num_drained_stores + core_drained_stores[i];
+        end
+        perf_fetch_stall_cycles <= perf_fetch_stall_cycles + num_warps_fetching;
+        perf_barrier_wait_cycles <= perf_barrier_wait_cycles + num_warps_at_barrier;
+        perf_uniform_loads <= perf_uniform_loads + data_t'($countones(core_uniform_load_executed));
+        perf_scheduler_idle_cycles <= perf_scheduler_idle_cycles + data_t'($countones(core_scheduler_idle));
+        perf_posted_stores <= perf_posted_stores + num_posted_stores;
+        perf_drained_stores <= perf_drained_stores + num_drained_stores;
+        perf_shared_memory_accesses <= perf_shared_memory_accesses + data_t'($countones(core_shared_memory_access));
+        perf_shared_memory_bank_conflicts <= perf_shared_memory_bank_conflicts + data_t'($countones(core_shared_memory_bank_conflict));
+        perf_zero_mask_skips <= perf_zero_mask_skips + data_t'($countones(core_zero_mask_skipped));
+    end
+end
+
+always_comb begin
+    perf_icache_hits = 0;
+    perf_icache_misses = 0;
+    perf_dcache_hits = 0;
+    perf_dcache_misses = 0;
+    perf_dcache_transactions = 0;
+    for (int i = 0; i < NUM_CORES; i = i + 1) begin
+        perf_icache_hits = perf_icache_hits + core_icache_hits[i];
+        perf_icache_misses = perf_icache_misses + core_icache_misses[i];
+        perf_dcache_hits = perf_dcache_hits + core_dcache_hits[i];
+        perf_dcache_misses = perf_dcache_misses + core_dcache_misses[i];
+        perf_dcache_transactions = perf_dcache_transactions + core_dcache_transactions[i];
+    end
+end
+
 dispatcher #(
-    .NUM_CORES(NUM_CORES)
+    .NUM_CORES(NUM_CORES),
+    .WARPS_PER_CORE(WARPS_PER_CORE),
+    .BLOCKS_PER_CORE(BLOCKS_PER_CORE),
+    .BLOCK_RELAUNCH(BLOCK_RELAUNCH)
     ) dispatcher_inst (
     .clk(clk),
     .reset(reset),
@@ -89,74 +261,143 @@ dispatcher #(
 
     .kernel_config(kernel_config_reg),
 
-    .core_done(core_done),
-    .core_start(core_start),
     .core_reset(core_reset),
-    .core_block_id(core_block_id),
 
-    .done(execution_done)
+    .block_done(block_done),
+    .block_start(block_start),
+    .block_reset(block_reset),
+    .block_relaunch(block_relaunch),
+    .block_id(block_id),
+    .resident_blocks(resident_blocks),
+
+    .done(dispatcher_done)
 );
 
 // Data Memory Controller
 mem_controller #(
     .DATA_WIDTH(`DATA_WIDTH),
     .ADDRESS_WIDTH(`DATA_MEMORY_ADDRESS_WIDTH),
-    .NUM_CONSUMERS(NUM_LSUS),
-    .NUM_CHANNELS(DATA_MEM_NUM_CHANNELS)
+    .NUM_CONSUMERS(NUM_DATA_MEM_CONSUMERS),
+    .NUM_CHANNELS(DATA_MEM_NUM_CHANNELS),
+    .ARBITRATION_POLICY(MEM_ARBITRATION_POLICY),
+    .CONSUMERS_PER_GROUP(DCACHE_ENABLE ? NUM_DCACHE_PORTS : NUM_LSUS_PER_CORE),
+    .MAX_OUTSTANDING(MEM_MAX_OUTSTANDING),
+    .CHANNEL_MAPPING(DATA_MEM_CHANNEL_MAPPING),
+    .INTERLEAVE_SHIFT(DATA_MEM_INTERLEAVE_SHIFT)
     ) data_memory_controller (
         .clk(clk),
         .reset(reset),
 
-        .consumer_read_valid(lsu_read_valid),
-        .consumer_read_address(lsu_read_address),
-        .consumer_read_ready(lsu_read_ready),
-        .consumer_read_data(lsu_read_data),
+        .consumer_read_valid(data_mem_consumer_read_valid),
+        .consumer_read_address(data_mem_consumer_read_address),
+        .consumer_read_atomic_op(data_mem_consumer_read_atomic_op),
+        .consumer_read_atomic_operand(data_mem_consumer_read_atomic_operand),
+        .consumer_read_atomic_compare(data_mem_consumer_read_atomic_compare),
+        .consumer_read_ready(data_mem_consumer_read_ready),
+        .consumer_read_data(data_mem_consumer_read_data),
 
-        .consumer_write_valid(lsu_write_valid),
-        .consumer_write_address(lsu_write_address),
-        .consumer_write_data(lsu_write_data),
-        .consumer_write_ready(lsu_write_ready),
+        .consumer_write_valid(data_mem_consumer_write_valid),
+        .consumer_write_address(data_mem_consumer_write_address),
+        .consumer_write_data(data_mem_consumer_write_data),
+        .consumer_write_ready(data_mem_consumer_write_ready),
 
         .mem_read_valid(data_mem_read_valid),
         .mem_read_address(data_mem_read_address),
+        .mem_read_tag(data_mem_read_tag),
+        .mem_read_atomic_op(data_mem_read_atomic_op),
+        .mem_read_atomic_operand(data_mem_read_atomic_operand),
+        .mem_read_atomic_compare(data_mem_read_atomic_compare),
         .mem_read_ready(data_mem_read_ready),
         .mem_read_data(data_mem_read_data),
+        .mem_read_response_tag(data_mem_read_response_tag),
 
         .mem_write_valid(data_mem_write_valid),
         .mem_write_address(data_mem_write_address),
         .mem_write_data(data_mem_write_data),
-        .mem_write_ready(data_mem_write_ready)
+        .mem_write_tag(data_mem_write_tag),
+        .mem_write_ready(data_mem_write_ready),
+        .mem_write_response_tag(data_mem_write_response_tag),
+
+        .consumer_wait_cycles(perf_data_mem_wait_cycles),
+        .merged_reads()
     );
 
+generate
+    if (!DCACHE_ENABLE) begin : g_no_dcache
+        assign data_mem_consumer_read_valid = lsu_read_valid;
+        assign lsu_read_ready = data_mem_consumer_read_ready;
+        assign data_mem_consumer_write_valid = lsu_write_valid;
+        assign lsu_write_ready = data_mem_consumer_write_ready;
+        for (genvar i = 0; i < NUM_LSUS; i = i + 1) begin : g_lsu_connect
+            assign data_mem_consumer_read_address[i] = lsu_read_address[i];
+            assign data_mem_consumer_read_atomic_op[i] = lsu_read_atomic_op[i];
+            assign data_mem_consumer_read_atomic_operand[i] = lsu_read_atomic_operand[i];
+            assign data_mem_consumer_read_atomic_compare[i] = lsu_read_atomic_compare[i];
+            assign lsu_read_data[i] = data_mem_consumer_read_data[i];
+            assign data_mem_consumer_write_address[i] = lsu_write_address[i];
+            assign data_mem_consumer_write_data[i] = lsu_write_data[i];
+        end
+        for (genvar i = 0; i < NUM_CORES; i = i + 1) begin : g_dcache_stats
+            assign dcache_flushed[i] = 1;
+            assign core_dcache_hits[i] = 0;
+            assign core_dcache_misses[i] = 0;
+            assign core_dcache_transactions[i] = 0;
+        end
+    end
+endgenerate
+
 
 
 // Instruction Memory Controller
 
-// Disconnected write wires
+// Disconnected write wires, program memory has no atomics either
 
-logic [NUM_FETCHERS-1:0] d_consumer_write_valid;
-instruction_memory_address_t d_consumer_write_address [NUM_FETCHERS];
-instruction_t d_consumer_write_data [NUM_FETCHERS];
-logic [NUM_FETCHERS-1:0] d_consumer_write_ready;
+atomic_op_t d_consumer_read_atomic_op [NUM_PROGRAM_MEM_CONSUMERS];
+instruction_t d_consumer_read_atomic_operand [NUM_PROGRAM_MEM_CONSUMERS];
+instruction_t d_consumer_read_atomic_compare [NUM_PROGRAM_MEM_CONSUMERS];
+logic [NUM_PROGRAM_MEM_CONSUMERS-1:0] d_consumer_write_valid;
+instruction_memory_address_t d_consumer_write_address [NUM_PROGRAM_MEM_CONSUMERS];
+instruction_t d_consumer_write_data [NUM_PROGRAM_MEM_CONSUMERS];
+logic [NUM_PROGRAM_MEM_CONSUMERS-1:0] d_consumer_write_ready;
 
 logic [INSTRUCTION_MEM_NUM_CHANNELS-1:0] d_mem_write_valid;
 logic [`INSTRUCTION_MEMORY_ADDRESS_WIDTH-1:0] d_mem_write_address [INSTRUCTION_MEM_NUM_CHANNELS];
 logic [`INSTRUCTION_WIDTH-1:0] d_mem_write_data [INSTRUCTION_MEM_NUM_CHANNELS];
+mem_tag_t d_mem_write_tag [INSTRUCTION_MEM_NUM_CHANNELS];
+mem_tag_t d_mem_write_response_tag [INSTRUCTION_MEM_NUM_CHANNELS];
+atomic_op_t d_mem_read_atomic_op [INSTRUCTION_MEM_NUM_CHANNELS];
+logic [`INSTRUCTION_WIDTH-1:0] d_mem_read_atomic_operand [INSTRUCTION_MEM_NUM_CHANNELS];
+logic [`INSTRUCTION_WIDTH-1:0] d_mem_read_atomic_compare [INSTRUCTION_MEM_NUM_CHANNELS];
+
+always_comb begin
+    for (int i = 0; i < NUM_PROGRAM_MEM_CONSUMERS; i = i + 1) begin
+        d_consumer_read_atomic_op[i] = ATOMIC_NONE;
+        d_consumer_read_atomic_operand[i] = 0;
+        d_consumer_read_atomic_compare[i] = 0;
+    end
+end
 
 mem_controller #(
     .DATA_WIDTH(`INSTRUCTION_WIDTH),
     .ADDRESS_WIDTH(`INSTRUCTION_MEMORY_ADDRESS_WIDTH),
-    .NUM_CONSUMERS(NUM_FETCHERS),
+    .NUM_CONSUMERS(NUM_PROGRAM_MEM_CONSUMERS),
     .NUM_CHANNELS(INSTRUCTION_MEM_NUM_CHANNELS),
-    .WRITE_ENABLE(0)
+    .WRITE_ENABLE(0),
+    .ARBITRATION_POLICY(MEM_ARBITRATION_POLICY),
+    .CONSUMERS_PER_GROUP(ICACHE_ENABLE ? 1 : WARPS_PER_CORE),
+    .MAX_OUTSTANDING(MEM_MAX_OUTSTANDING),
+    .MERGE_READS(FETCH_MERGE)
 ) program_memory_controller (
     .clk(clk),
     .reset(reset),
 
-    .consumer_read_valid(fetcher_read_valid),
-    .consumer_read_address(fetcher_read_address),
-    .consumer_read_ready(fetcher_read_ready),
-    .consumer_read_data(fetcher_read_data),
+    .consumer_read_valid(program_mem_read_valid),
+    .consumer_read_address(program_mem_read_address),
+    .consumer_read_atomic_op(d_consumer_read_atomic_op),
+    .consumer_read_atomic_operand(d_consumer_read_atomic_operand),
+    .consumer_read_atomic_compare(d_consumer_read_atomic_compare),
+    .consumer_read_ready(program_mem_read_ready),
+    .consumer_read_data(program_mem_read_data),
 
     .consumer_write_valid(d_consumer_write_valid),
     .consumer_write_address(d_consumer_write_address),
@@ -165,15 +406,40 @@ mem_controller #(
 
     .mem_read_valid(instruction_mem_read_valid),
     .mem_read_address(instruction_mem_read_address),
+    .mem_read_tag(instruction_mem_read_tag),
+    .mem_read_atomic_op(d_mem_read_atomic_op),
+    .mem_read_atomic_operand(d_mem_read_atomic_operand),
+    .mem_read_atomic_compare(d_mem_read_atomic_compare),
     .mem_read_ready(instruction_mem_read_ready),
     .mem_read_data(instruction_mem_read_data),
+    .mem_read_response_tag(instruction_mem_read_response_tag),
 
     .mem_write_valid(d_mem_write_valid),
     .mem_write_address(d_mem_write_address),
     .mem_write_data(d_mem_write_data),
-    .mem_write_ready(0)
+    .mem_write_tag(d_mem_write_tag),
+    .mem_write_ready(0),
+    .mem_write_response_tag(d_mem_write_response_tag),
+
+    .consumer_wait_cycles(perf_instruction_mem_wait_cycles),
+    .merged_reads(perf_merged_fetches)
 );
 
+generate
+    if (!ICACHE_ENABLE) begin : g_no_icache
+        assign program_mem_read_valid = fetcher_read_valid;
+        assign fetcher_read_ready = program_mem_read_ready;
+        for (genvar i = 0; i < NUM_FETCHERS; i = i + 1) begin : g_fetcher_connect
+            assign program_mem_read_address[i] = fetcher_read_address[i];
+            assign fetcher_read_data[i] = program_mem_read_data[i];
+        end
+        for (genvar i = 0; i < NUM_CORES; i = i + 1) begin : g_icache_stats
+            assign core_icache_hits[i] = 0;
+            assign core_icache_misses[i] = 0;
+        end
+    end
+endgenerate
+
 initial begin
     $display("Hello, World!");
 end
@@ -185,6 +451,9 @@ generate
         // by the OpenLane EDA flow (uses Verilog 2005) that prevents slicing the top-level signals
         logic [NUM_LSUS_PER_CORE-1:0] core_lsu_read_valid;
         data_memory_address_t core_lsu_read_address [NUM_LSUS_PER_CORE];
+        atomic_op_t core_lsu_read_atomic_op [NUM_LSUS_PER_CORE];
+        data_t core_lsu_read_atomic_operand [NUM_LSUS_PER_CORE];
+        data_t core_lsu_read_atomic_compare [NUM_LSUS_PER_CORE];
         logic [NUM_LSUS_PER_CORE-1:0] core_lsu_read_ready;
         data_t core_lsu_read_data [NUM_LSUS_PER_CORE];
         logic [NUM_LSUS_PER_CORE-1:0] core_lsu_write_valid;
@@ -199,6 +468,9 @@ generate
             always @(posedge clk) begin
                 lsu_read_valid[lsu_index] <= core_lsu_read_valid[j];
                 lsu_read_address[lsu_index] <= core_lsu_read_address[j];
+                lsu_read_atomic_op[lsu_index] <= core_lsu_read_atomic_op[j];
+                lsu_read_atomic_operand[lsu_index] <= core_lsu_read_atomic_operand[j];
+                lsu_read_atomic_compare[lsu_index] <= core_lsu_read_atomic_compare[j];
 
                 lsu_write_valid[lsu_index] <= core_lsu_write_valid[j];
                 lsu_write_address[lsu_index] <= core_lsu_write_address[j];
@@ -211,19 +483,114 @@ generate
         end
 
         localparam fetcher_index = i * WARPS_PER_CORE;
+        localparam lsu_base_index = i * NUM_LSUS_PER_CORE;
+
+        // Data Cache
+        if (DCACHE_ENABLE) begin : g_dcache
+            data_cache #(
+                .NUM_CONSUMERS(NUM_LSUS_PER_CORE),
+                .CACHE_SIZE(DCACHE_SIZE),
+                .LINE_SIZE(DCACHE_LINE_SIZE),
+                .ASSOCIATIVITY(DCACHE_ASSOCIATIVITY),
+                .NUM_MSHRS(DCACHE_NUM_MSHRS),
+                .NUM_WRITE_PORTS(DCACHE_NUM_WRITE_PORTS),
+                .NUM_LOOKUP_PORTS(DCACHE_NUM_LOOKUP_PORTS),
+                .WRITE_BACK(DCACHE_WRITE_BACK),
+                .COALESCE(DCACHE_COALESCE)
+            ) dcache_instance (
+                .clk(clk),
+                .reset(reset),
+
+                .consumer_read_valid(lsu_read_valid[lsu_base_index +: NUM_LSUS_PER_CORE]),
+                .consumer_read_address(lsu_read_address[lsu_base_index +: NUM_LSUS_PER_CORE]),
+                .consumer_read_atomic_op(lsu_read_atomic_op[lsu_base_index +: NUM_LSUS_PER_CORE]),
+                .consumer_read_atomic_operand(lsu_read_atomic_operand[lsu_base_index +: NUM_LSUS_PER_CORE]),
+                .consumer_read_atomic_compare(lsu_read_atomic_compare[lsu_base_index +: NUM_LSUS_PER_CORE]),
+                .consumer_read_ready(lsu_read_ready[lsu_base_index +: NUM_LSUS_PER_CORE]),
+                .consumer_read_data(lsu_read_data[lsu_base_index +: NUM_LSUS_PER_CORE]),
+                .consumer_write_valid(lsu_write_valid[lsu_base_index +: NUM_LSUS_PER_CORE]),
+                .consumer_write_address(lsu_write_address[lsu_base_index +: NUM_LSUS_PER_CORE]),
+                .consumer_write_data(lsu_write_data[lsu_base_index +: NUM_LSUS_PER_CORE]),
+                .consumer_write_ready(lsu_write_ready[lsu_base_index +: NUM_LSUS_PER_CORE]),
+
+                .mem_read_valid(data_mem_consumer_read_valid[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+                .mem_read_address(data_mem_consumer_read_address[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+                .mem_read_atomic_op(data_mem_consumer_read_atomic_op[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+                .mem_read_atomic_operand(data_mem_consumer_read_atomic_operand[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+                .mem_read_atomic_compare(data_mem_consumer_read_atomic_compare[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+                .mem_read_ready(data_mem_consumer_read_ready[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+                .mem_read_data(data_mem_consumer_read_data[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+                .mem_write_valid(data_mem_consumer_write_valid[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+                .mem_write_address(data_mem_consumer_write_address[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+                .mem_write_data(data_mem_consumer_write_data[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+                .mem_write_ready(data_mem_consumer_write_ready[i * NUM_DCACHE_PORTS +: NUM_DCACHE_PORTS]),
+
+                .flush(dispatcher_done),
+                .flushed(dcache_flushed[i]),
+
+                .hits(core_dcache_hits[i]),
+                .misses(core_dcache_misses[i]),
+                .transactions(core_dcache_transactions[i])
+            );
+        end
+
+        // Instruction Cache
+        if (ICACHE_ENABLE) begin : g_icache
+            instruction_cache #(
+                .NUM_CONSUMERS(WARPS_PER_CORE),
+                .CACHE_SIZE(ICACHE_SIZE),
+                .LINE_SIZE(ICACHE_LINE_SIZE),
+                .ASSOCIATIVITY(ICACHE_ASSOCIATIVITY)
+            ) icache_instance (
+                .clk(clk),
+                .reset(reset),
+
+                .consumer_read_valid(fetcher_read_valid[fetcher_index +: WARPS_PER_CORE]),
+                .consumer_read_address(fetcher_read_address[fetcher_index +: WARPS_PER_CORE]),
+                .consumer_read_ready(fetcher_read_ready[fetcher_index +: WARPS_PER_CORE]),
+                .consumer_read_data(fetcher_read_data[fetcher_index +: WARPS_PER_CORE]),
+
+                .mem_read_valid(program_mem_read_valid[i]),
+                .mem_read_address(program_mem_read_address[i]),
+                .mem_read_ready(program_mem_read_ready[i]),
+                .mem_read_data(program_mem_read_data[i]),
+
+                .hits(core_icache_hits[i]),
+                .misses(core_icache_misses[i])
+            );
+        end
 
         // Compute Core
         compute_core #(
             .WARPS_PER_CORE(WARPS_PER_CORE),
-            .THREADS_PER_WARP(THREADS_PER_WARP)
+            .BLOCKS_PER_CORE(BLOCKS_PER_CORE),
+            .THREADS_PER_WARP(THREADS_PER_WARP),
+            .UNIFORM_LOAD_BROADCAST(UNIFORM_LOAD_BROADCAST),
+            .WARP_SWITCH_ON_STALL(WARP_SWITCH_ON_STALL),
+            .SCHEDULER_POLICY(SCHEDULER_POLICY),
+            .SCHEDULER_ACTIVE_WARPS(SCHEDULER_ACTIVE_WARPS),
+            .PREFETCH_DEPTH(PREFETCH_DEPTH),
+            .REGISTER_SCOREBOARD(REGISTER_SCOREBOARD),
+            .WRITE_BUFFER_DEPTH(WRITE_BUFFER_DEPTH),
+            .WRITE_COMBINE_WINDOW(WRITE_COMBINE_WINDOW),
+            .WRITE_COMBINE_LINE_SIZE(DCACHE_LINE_SIZE),
+            .SHARED_MEMORY_SIZE(SHARED_MEMORY_SIZE),
+            .SHARED_MEMORY_BANKS(SHARED_MEMORY_BANKS),
+            .MASK_STACK_DEPTH(MASK_STACK_DEPTH),
+            .ZERO_MASK_SKIP(ZERO_MASK_SKIP),
+            .MUL_LATENCY(MUL_LATENCY),
+            .DIV_LATENCY(DIV_LATENCY)
         ) core_instance (
             .clk(clk),
             .reset(core_reset[i]),
 
-            .start(core_start[i]),
-            .done(core_done[i]),
+            .start(block_start[i * BLOCKS_PER_CORE +: BLOCKS_PER_CORE]),
+            .block_reset(block_reset[i * BLOCKS_PER_CORE +: BLOCKS_PER_CORE]),
+            .block_relaunch(block_relaunch[i * BLOCKS_PER_CORE +: BLOCKS_PER_CORE]),
+            .done(block_done[i * BLOCKS_PER_CORE +: BLOCKS_PER_CORE]),
 
-            .block_id(core_block_id[i]),
+            .block_id(block_id[i * BLOCKS_PER_CORE +: BLOCKS_PER_CORE]),
+            .resident_blocks(resident_blocks),
             .kernel_config(kernel_config_reg),
 
             .instruction_mem_read_valid(fetcher_read_valid[fetcher_index +: WARPS_PER_CORE]),
@@ -233,12 +600,25 @@ generate
 
             .data_mem_read_valid(core_lsu_read_valid),
             .data_mem_read_address(core_lsu_read_address),
+            .data_mem_read_atomic_op(core_lsu_read_atomic_op),
+            .data_mem_read_atomic_operand(core_lsu_read_atomic_operand),
+            .data_mem_read_atomic_compare(core_lsu_read_atomic_compare),
             .data_mem_read_ready(core_lsu_read_ready),
             .data_mem_read_data(core_lsu_read_data),
             .data_mem_write_valid(core_lsu_write_valid),
             .data_mem_write_address(core_lsu_write_address),
             .data_mem_write_data(core_lsu_write_data),
-            .data_mem_write_ready(core_lsu_write_ready)
+            .data_mem_write_ready(core_lsu_write_ready),
+
+            .num_warps_fetching(core_num_warps_fetching[i]),
+            .num_warps_at_barrier(core_num_warps_at_barrier[i]),
+            .uniform_load_executed(core_uniform_load_executed[i]),
+            .scheduler_idle(core_scheduler_idle[i]),
+            .posted_stores(core_posted_stores[i]),
+            .drained_stores(core_drained_stores[i]),
+            .shared_memory_access(core_shared_memory_access[i]),
+            .shared_memory_bank_conflict(core_shared_memory_bank_conflict[i]),
+            .zero_mask_skipped(core_zero_mask_skipped[i])
         );
     end
 endgenerate
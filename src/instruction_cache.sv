@@ -0,0 +1,166 @@
+`default_nettype none
+`timescale 1ns/1ns
+
+`include "common.sv"
+
+// INSTRUCTION CACHE
+// > Sits between the fetchers of a single core and the program memory controller
+// > Set-associative and read-only, with round-robin replacement within a set
+// > Serves one hit per cycle, hits are still served while a line is being filled
+// > Lines are filled word by word through a single program memory controller port
+module instruction_cache #(
+    parameter int NUM_CONSUMERS = 4,        // Number of fetchers served by this cache
+    parameter int CACHE_SIZE = 256,         // Total number of instructions held by the cache
+    parameter int LINE_SIZE = 4,            // Number of instructions per cache line
+    parameter int ASSOCIATIVITY = 2         // Number of ways per set
+) (
+    input wire clk,
+    input wire reset,
+
+    // Consumer Interface (Fetchers)
+    input wire [NUM_CONSUMERS-1:0] consumer_read_valid,
+    input instruction_memory_address_t consumer_read_address [NUM_CONSUMERS],
+    output logic [NUM_CONSUMERS-1:0] consumer_read_ready,
+    output instruction_t consumer_read_data [NUM_CONSUMERS],
+
+    // Memory Interface (Program Memory Controller)
+    output logic mem_read_valid,
+    output instruction_memory_address_t mem_read_address,
+    input wire mem_read_ready,
+    input instruction_t mem_read_data,
+
+    // Statistics
+    output data_t hits,
+    output data_t misses
+);
+localparam int NUM_SETS = CACHE_SIZE / (LINE_SIZE * ASSOCIATIVITY);
+
+// Tags hold the whole line address, which keeps the lookup independent of the set count
+logic line_valid [NUM_SETS][ASSOCIATIVITY];
+instruction_memory_address_t line_tag [NUM_SETS][ASSOCIATIVITY];
+instruction_t line_data [NUM_SETS][ASSOCIATIVITY][LINE_SIZE];
+int replacement_way [NUM_SETS];
+
+// Round-robin pointer, so that no fetcher is starved by the lookup port
+int next_consumer;
+logic [NUM_CONSUMERS-1:0] consumer_missed;          // The request was already counted as a miss
+
+// Line fill state
+cache_port_state_t fill_state;
+instruction_memory_address_t fill_line_address;
+int fill_set;
+int fill_way;
+int fill_offset;
+
+always @(posedge clk) begin
+    if (reset) begin
+        for (int i = 0; i < NUM_CONSUMERS; i++) begin
+            consumer_read_ready[i] <= 0;
+            consumer_read_data[i] <= 0;
+        end
+        for (int i = 0; i < NUM_SETS; i++) begin
+            for (int j = 0; j < ASSOCIATIVITY; j++) begin
+                line_valid[i][j] <= 0;
+            end
+            replacement_way[i] <= 0;
+        end
+        next_consumer <= 0;
+        consumer_missed <= 0;
+        fill_state <= PORT_IDLE;
+        mem_read_valid <= 0;
+        mem_read_address <= 0;
+        hits <= 0;
+        misses <= 0;
+    end else begin
+        // Wait until the consumer acknowledges it received the response, then reset
+        for (int i = 0; i < NUM_CONSUMERS; i++) begin
+            if (consumer_read_ready[i] && !consumer_read_valid[i]) begin
+                consumer_read_ready[i] <= 0;
+            end
+        end
+
+        // Look up a single pending request per cycle
+        for (int k = 0; k < NUM_CONSUMERS; k++) begin
+            int consumer = (next_consumer + k) % NUM_CONSUMERS;
+            if (consumer_read_valid[consumer] && !consumer_read_ready[consumer]) begin
+                instruction_memory_address_t line_address = consumer_read_address[consumer] / LINE_SIZE;
+                int set = int'(line_address % NUM_SETS);
+                int hit_way = -1;
+
+                for (int way = 0; way < ASSOCIATIVITY; way++) begin
+                    if (line_valid[set][way] && line_tag[set][way] == line_address) begin
+                        hit_way = way;
+                    end
+                end
+
+                if (hit_way != -1) begin
+                    consumer_read_ready[consumer] <= 1;
+                    consumer_read_data[consumer] <= line_data[set][hit_way][consumer_read_address[consumer] % LINE_SIZE];
+                    // A request served from the line it filled itself stays a miss
+                    if (consumer_missed[consumer]) begin
+                        consumer_missed[consumer] <= 0;
+                    end else begin
+                        hits <= hits + 1;
+                    end
+                    next_consumer <= (consumer + 1) % NUM_CONSUMERS;
+                    break;
+                end else if (fill_state == PORT_IDLE) begin
+                    // Evict the replacement candidate and start filling the line
+                    line_valid[set][replacement_way[set]] <= 0;
+                    replacement_way[set] <= (replacement_way[set] + 1) % ASSOCIATIVITY;
+
+                    fill_line_address <= line_address;
+                    fill_set <= set;
+                    fill_way <= replacement_way[set];
+                    fill_offset <= 0;
+                    fill_state <= PORT_REQUESTING;
+
+                    mem_read_valid <= 1;
+                    mem_read_address <= line_address * LINE_SIZE;
+                    if (!consumer_missed[consumer]) begin
+                        consumer_missed[consumer] <= 1;
+                        misses <= misses + 1;
+                    end
+                    next_consumer <= (consumer + 1) % NUM_CONSUMERS;
+                    break;
+                end
+                // The fill port is busy, so this request has to wait, try to find a hit for another fetcher
+            end
+        end
+
+        // Fill the line word by word using the same handshake as the fetchers
+        case (fill_state)
+            PORT_IDLE: begin
+            end
+            PORT_REQUESTING: begin
+                if (mem_read_ready) begin
+                    mem_read_valid <= 0;
+                    line_data[fill_set][fill_way][fill_offset] <= mem_read_data;
+                    if (fill_offset == LINE_SIZE - 1) begin
+                        line_tag[fill_set][fill_way] <= fill_line_address;
+                        line_valid[fill_set][fill_way] <= 1;
+                    end
+                    fill_state <= PORT_RELEASING;
+                end
+            end
+            PORT_RELEASING: begin
+                // Wait for the memory controller to release the channel before sending another request
+                if (!mem_read_ready) begin
+                    if (fill_offset == LINE_SIZE - 1) begin
+                        fill_state <= PORT_IDLE;
+                    end else begin
+                        fill_offset <= fill_offset + 1;
+                        mem_read_valid <= 1;
+                        mem_read_address <= fill_line_address * LINE_SIZE + instruction_memory_address_t'(fill_offset + 1);
+                        fill_state <= PORT_REQUESTING;
+                    end
+                end
+            end
+            default: begin
+                $error("Invalid instruction cache fill state");
+            end
+        endcase
+    end
+end
+
+endmodule
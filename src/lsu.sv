@@ -5,6 +5,7 @@
 // > Handles asynchronous memory load and store operations and waits for response
 // > Each thread in each core has it's own LSU
 // > LDR, STR instructions are executed here
+// > Atomic memory operations are loads whose request carries the operation, rs2 and (for AMOCAS) the compare value rs3
 module lsu (
     input wire clk,
     input wire reset,
@@ -16,15 +17,23 @@ module lsu (
     // Memory Control Signals
     input reg decoded_mem_read_enable,
     input reg decoded_mem_write_enable,
+    input atomic_op_t decoded_atomic_op,
 
     // Registers
     input data_t rs1,
     input data_t rs2,
+    input data_t rs3,
     input data_t imm,
 
+    // The load is served by another lane of the warp reading the same address, so no request is sent
+    input wire broadcast_follower,
+
     // Data Memory
     output logic mem_read_valid,
     output data_memory_address_t mem_read_address,
+    output atomic_op_t mem_read_atomic_op,
+    output data_t mem_read_atomic_operand,
+    output data_t mem_read_atomic_compare,
     input logic mem_read_ready,
     input data_t mem_read_data,
     output logic mem_write_valid,
@@ -46,6 +55,9 @@ always @(posedge clk) begin
         lsu_out <= 0;
         mem_read_valid <= 0;
         mem_read_address <= 0;
+        mem_read_atomic_op <= ATOMIC_NONE;
+        mem_read_atomic_operand <= 0;
+        mem_read_atomic_compare <= 0;
         mem_write_valid <= 0;
         mem_write_address <= 0;
         mem_write_data <= 0;
@@ -60,9 +72,16 @@ always @(posedge clk) begin
                     end
                 end
                 LSU_REQUESTING: begin 
-                    mem_read_valid <= 1;
-                    mem_read_address <= offset_address;
-                    lsu_state <= LSU_WAITING;
+                    if (broadcast_follower) begin
+                        lsu_state <= LSU_DONE;
+                    end else begin
+                        mem_read_valid <= 1;
+                        mem_read_address <= offset_address;
+                        mem_read_atomic_op <= decoded_atomic_op;
+                        mem_read_atomic_operand <= rs2;
+                        mem_read_atomic_compare <= rs3;
+                        lsu_state <= LSU_WAITING;
+                    end
                 end
                 LSU_WAITING: begin
                     if (mem_read_ready == 1) begin
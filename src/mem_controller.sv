@@ -1,12 +1,31 @@
 `default_nettype none
 `timescale 1ns/1ns
 
+`include "common.sv"
+
+// MEMORY CONTROLLER
+// > Relays requests from consumers (fetchers / LSUs / caches) to memory over NUM_CHANNELS channels
+// > Channels are pipelined: each one can send a new request every cycle and have up to MAX_OUTSTANDING requests in flight
+// > Requests are tagged with the consumer index, memory may answer them in any order
+// > Consumers see the usual handshake, ready is held until the consumer drops valid
+// > With interleaved channel mapping, each channel only serves requests whose address maps to it,
+//   so consecutive blocks of 2^INTERLEAVE_SHIFT words are spread over the channels (and the memory banks behind them)
+// > With read merging, consumers reading an address that another consumer's request is already fetching
+//   attach to that request instead of sending their own, and the response is broadcast to all of them
+// > Reads can carry an atomic operation, memory then updates the word in the same transaction and answers with its old value.
+//   Atomics are never merged, and only controllers that can write to memory forward them
 module mem_controller #(
     parameter int DATA_WIDTH,
     parameter int ADDRESS_WIDTH,
     parameter int NUM_CONSUMERS, // The number of consumers accessing memory through this controller
     parameter int NUM_CHANNELS,  // The number of concurrent channels available to send requests to global memory
-    parameter int WRITE_ENABLE = 1   // Whether this memory controller can write to memory (program memory is read-only)
+    parameter int WRITE_ENABLE = 1,  // Whether this memory controller can write to memory (program memory is read-only)
+    parameter int ARBITRATION_POLICY = `ARBITRATION_ROUND_ROBIN, // How idle channels choose between pending consumers
+    parameter int CONSUMERS_PER_GROUP = 1, // Number of consecutive consumers belonging to one core, used by the fair share policy
+    parameter int MAX_OUTSTANDING = 4, // The number of requests each channel can have in flight
+    parameter int CHANNEL_MAPPING = `CHANNEL_MAPPING_ANY, // How requests are assigned to channels
+    parameter int INTERLEAVE_SHIFT = 0, // Interleaved mapping: channel = (address >> INTERLEAVE_SHIFT) % NUM_CHANNELS
+    parameter int MERGE_READS = 0 // Whether reads of the same address share one memory request
 ) (
     input wire clk,
     input wire reset,
@@ -14,6 +33,9 @@ module mem_controller #(
     // Consumer Interface (Fetchers / LSUs)
     input reg [NUM_CONSUMERS-1:0] consumer_read_valid,
     input reg [ADDRESS_WIDTH-1:0] consumer_read_address [NUM_CONSUMERS],
+    input atomic_op_t consumer_read_atomic_op [NUM_CONSUMERS],
+    input reg [DATA_WIDTH-1:0] consumer_read_atomic_operand [NUM_CONSUMERS],
+    input reg [DATA_WIDTH-1:0] consumer_read_atomic_compare [NUM_CONSUMERS],
     output reg [NUM_CONSUMERS-1:0] consumer_read_ready,
     output reg [DATA_WIDTH-1:0] consumer_read_data [NUM_CONSUMERS],
     input reg [NUM_CONSUMERS-1:0] consumer_write_valid,
@@ -22,25 +44,55 @@ module mem_controller #(
     output reg [NUM_CONSUMERS-1:0] consumer_write_ready,
 
     // Memory Interface (Data / Program)
+    // valid is raised for a single cycle per request, ready is raised for a single cycle per response
     output reg [NUM_CHANNELS-1:0] mem_read_valid,
     output reg [ADDRESS_WIDTH-1:0] mem_read_address [NUM_CHANNELS],
+    output mem_tag_t mem_read_tag [NUM_CHANNELS],
+    output atomic_op_t mem_read_atomic_op [NUM_CHANNELS],
+    output reg [DATA_WIDTH-1:0] mem_read_atomic_operand [NUM_CHANNELS],
+    output reg [DATA_WIDTH-1:0] mem_read_atomic_compare [NUM_CHANNELS],
     input reg [NUM_CHANNELS-1:0] mem_read_ready,
     input reg [DATA_WIDTH-1:0] mem_read_data [NUM_CHANNELS],
+    input mem_tag_t mem_read_response_tag [NUM_CHANNELS],
     output reg [NUM_CHANNELS-1:0] mem_write_valid,
     output reg [ADDRESS_WIDTH-1:0] mem_write_address [NUM_CHANNELS],
     output reg [DATA_WIDTH-1:0] mem_write_data [NUM_CHANNELS],
-    input reg [NUM_CHANNELS-1:0] mem_write_ready
+    output mem_tag_t mem_write_tag [NUM_CHANNELS],
+    input reg [NUM_CHANNELS-1:0] mem_write_ready,
+    input mem_tag_t mem_write_response_tag [NUM_CHANNELS],
+
+    // Statistics
+    output data_t consumer_wait_cycles [NUM_CONSUMERS], // Cycles each consumer spent with a request that no channel picked up yet
+    output data_t merged_reads // Reads served by the memory request of another consumer
 );
-    localparam IDLE = 3'b000,
-        READ_WAITING = 3'b010,
-        WRITE_WAITING = 3'b011,
-        READ_RELAYING = 3'b100,
-        WRITE_RELAYING = 3'b101;
+    // Keep track of the requests in flight on each channel
+    int outstanding_requests [NUM_CHANNELS];
+    reg [NUM_CONSUMERS-1:0] channel_serving_consumer; // Which consumers are being served? Prevents many channels from picking up the same request.
+
+    // Arbitration state
+    localparam int NUM_GROUPS = (NUM_CONSUMERS + CONSUMERS_PER_GROUP - 1) / CONSUMERS_PER_GROUP;
+    int next_consumer;                          // Round-robin: consumer with the highest priority
+    int next_group;                             // Fair share: group with the highest priority
+    int next_consumer_in_group [NUM_GROUPS];    // Fair share: round-robin position inside each group
+    data_t consumer_wait_age [NUM_CONSUMERS];   // Age-based: cycles the current request of each consumer has been waiting
+    reg [NUM_CONSUMERS-1:0] consumer_pending;
+
+    // Read merging: consumers waiting on the request of another consumer (the leader, whose index is the request tag)
+    reg [NUM_CONSUMERS-1:0] consumer_merged;
+    int consumer_merge_leader [NUM_CONSUMERS];
+    int num_merged;
 
-    // Keep track of state for each channel and which jobs each channel is handling
-    reg [2:0] controller_state [NUM_CHANNELS];
-    reg [$clog2(NUM_CONSUMERS)-1:0] current_consumer [NUM_CHANNELS]; // Which consumer is each channel currently serving
-    reg [NUM_CONSUMERS-1:0] channel_serving_consumer; // Which channels are being served? Prevents many workers from picking up the same request.
+    // Whether consumer j can attach to the read that consumer leader has in flight or is about to send
+    function automatic logic can_merge(int j, int leader);
+        return consumer_read_valid[j] && !channel_serving_consumer[j] && j != leader &&
+            consumer_read_address[j] == consumer_read_address[leader] &&
+            consumer_read_atomic_op[j] == ATOMIC_NONE && consumer_read_atomic_op[leader] == ATOMIC_NONE;
+    endfunction
+
+    // Channel that a request is queued on with interleaved mapping
+    function automatic int address_channel(logic [ADDRESS_WIDTH-1:0] address);
+        return int'((address >> INTERLEAVE_SHIFT) % NUM_CHANNELS);
+    endfunction
 
     always @(posedge clk) begin
         if (reset) begin
@@ -56,84 +108,180 @@ module mem_controller #(
 
                 mem_write_valid[i] <= 0;
 
-                current_consumer[i] <= 0;
-                controller_state[i] <= 0;
+                outstanding_requests[i] <= 0;
                 mem_read_address[i] <= 0;
+                mem_read_tag[i] <= 0;
+                mem_read_atomic_op[i] <= ATOMIC_NONE;
+                mem_read_atomic_operand[i] <= 0;
+                mem_read_atomic_compare[i] <= 0;
                 mem_write_address[i] <= 0;
                 mem_write_data[i] <= 0;
+                mem_write_tag[i] <= 0;
             end
 
             channel_serving_consumer = 0;
+            consumer_merged = 0;
+            for (int i = 0; i < NUM_CONSUMERS; i++) begin
+                consumer_merge_leader[i] = 0;
+            end
+            merged_reads <= 0;
+
+            next_consumer = 0;
+            next_group = 0;
+            for (int i = 0; i < NUM_GROUPS; i++) begin
+                next_consumer_in_group[i] = 0;
+            end
+            for (int i = 0; i < NUM_CONSUMERS; i++) begin
+                consumer_wait_age[i] <= 0;
+                consumer_wait_cycles[i] <= 0;
+            end
         end else begin
-            // For each channel, we handle processing concurrently
-            for (int i = 0; i < NUM_CHANNELS; i = i + 1) begin
-                case (controller_state[i])
-                    IDLE: begin
-                        // While this channel is idle, cycle through consumers looking for one with a pending request
+            num_merged = 0;
+
+            // Attach to reads that are already in flight, before their responses are relayed below
+            if (MERGE_READS == 1) begin
+                for (int leader = 0; leader < NUM_CONSUMERS; leader = leader + 1) begin
+                    if (channel_serving_consumer[leader] && !consumer_merged[leader] && consumer_read_valid[leader] && !consumer_read_ready[leader]) begin
                         for (int j = 0; j < NUM_CONSUMERS; j = j + 1) begin
-                            if (consumer_read_valid[j] && !channel_serving_consumer[j]) begin
+                            if (can_merge(j, leader)) begin
                                 channel_serving_consumer[j] = 1;
-                                current_consumer[i] <= j[$clog2(NUM_CONSUMERS)-1:0];
-
-                                mem_read_valid[i] <= 1;
-                                mem_read_address[i] <= consumer_read_address[j];
-                                controller_state[i] <= READ_WAITING;
+                                consumer_merged[j] = 1;
+                                consumer_merge_leader[j] = leader;
+                                num_merged = num_merged + 1;
+                            end
+                        end
+                    end
+                end
+            end
 
-                                // Once we find a pending request, pick it up with this channel and stop looking for requests
-                                break;
-                            end else if ((WRITE_ENABLE == 1) && consumer_write_valid[j] && !channel_serving_consumer[j]) begin
-                                channel_serving_consumer[j] = 1;
-                                current_consumer[i] <= j[$clog2(NUM_CONSUMERS)-1:0];
+            // For each channel, we handle processing concurrently
+            for (int i = 0; i < NUM_CHANNELS; i = i + 1) begin
+                int outstanding = outstanding_requests[i];
+                int chosen_consumer = -1;
 
-                                mem_write_valid[i] <= 1;
-                                mem_write_address[i] <= consumer_write_address[j];
-                                mem_write_data[i] <= consumer_write_data[j];
-                                controller_state[i] <= WRITE_WAITING;
+                // Relay the responses that arrived on this channel to the consumers they are tagged with
+                if (mem_read_ready[i]) begin
+                    consumer_read_ready[mem_read_response_tag[i]] <= 1;
+                    consumer_read_data[mem_read_response_tag[i]] <= mem_read_data[i];
+                    outstanding = outstanding - 1;
 
-                                // Once we find a pending request, pick it up with this channel and stop looking for requests
-                                break;
-                            end
+                    // Broadcast the response to the consumers that merged into this request
+                    for (int j = 0; j < NUM_CONSUMERS; j = j + 1) begin
+                        if (consumer_merged[j] && consumer_merge_leader[j] == int'(mem_read_response_tag[i])) begin
+                            consumer_read_ready[j] <= 1;
+                            consumer_read_data[j] <= mem_read_data[i];
+                            consumer_merged[j] = 0;
                         end
                     end
-                    READ_WAITING: begin
-                        // Wait for response from memory for pending read request
-                        if (mem_read_ready[i]) begin
-                            mem_read_valid[i] <= 0;
-                            consumer_read_ready[current_consumer[i]] <= 1;
-                            consumer_read_data[current_consumer[i]] <= mem_read_data[i];
-                            controller_state[i] <= READ_RELAYING;
+                end
+                if (mem_write_ready[i]) begin
+                    consumer_write_ready[mem_write_response_tag[i]] <= 1;
+                    outstanding = outstanding - 1;
+                end
+
+                // Send at most one new request per cycle, as long as the channel has room for it
+                mem_read_valid[i] <= 0;
+                mem_write_valid[i] <= 0;
+
+                if (outstanding < MAX_OUTSTANDING) begin
+                    for (int j = 0; j < NUM_CONSUMERS; j = j + 1) begin
+                        consumer_pending[j] = (consumer_read_valid[j] || ((WRITE_ENABLE == 1) && consumer_write_valid[j])) && !channel_serving_consumer[j];
+
+                        // Requests mapped to another channel wait in that channel's queue
+                        if (CHANNEL_MAPPING == `CHANNEL_MAPPING_INTERLEAVED) begin
+                            consumer_pending[j] = consumer_pending[j] && address_channel(consumer_read_valid[j] ? consumer_read_address[j] : consumer_write_address[j]) == i;
                         end
                     end
-                    WRITE_WAITING: begin
-                        // Wait for response from memory for pending write request
-                        if (mem_write_ready[i]) begin
-                            mem_write_valid[i] <= 0;
-                            consumer_write_ready[current_consumer[i]] <= 1;
-                            controller_state[i] <= WRITE_RELAYING;
+
+                    if (ARBITRATION_POLICY == `ARBITRATION_AGE_BASED) begin
+                        for (int j = 0; j < NUM_CONSUMERS; j = j + 1) begin
+                            if (consumer_pending[j] && (chosen_consumer == -1 || consumer_wait_age[j] > consumer_wait_age[chosen_consumer])) begin
+                                chosen_consumer = j;
+                            end
                         end
-                    end
-                    // Wait until consumer acknowledges it received response, then reset
-                    READ_RELAYING: begin
-                        if (!consumer_read_valid[current_consumer[i]]) begin
-                            channel_serving_consumer[current_consumer[i]] = 0;
-                            consumer_read_ready[current_consumer[i]] <= 0;
-                            controller_state[i] <= IDLE;
+                    end else if (ARBITRATION_POLICY == `ARBITRATION_FAIR_SHARE) begin
+                        for (int g = 0; g < NUM_GROUPS; g = g + 1) begin
+                            int group = (next_group + g) % NUM_GROUPS;
+                            for (int k = 0; k < CONSUMERS_PER_GROUP; k = k + 1) begin
+                                int j = group * CONSUMERS_PER_GROUP + (next_consumer_in_group[group] + k) % CONSUMERS_PER_GROUP;
+                                if (j < NUM_CONSUMERS && consumer_pending[j]) begin
+                                    chosen_consumer = j;
+                                    break;
+                                end
+                            end
+                            if (chosen_consumer != -1) begin
+                                next_group = (group + 1) % NUM_GROUPS;
+                                next_consumer_in_group[group] = (chosen_consumer - group * CONSUMERS_PER_GROUP + 1) % CONSUMERS_PER_GROUP;
+                                break;
+                            end
                         end
-                    end
-                    WRITE_RELAYING: begin
-                        if (!consumer_write_valid[current_consumer[i]]) begin
-                            channel_serving_consumer[current_consumer[i]] = 0;
-                            consumer_write_ready[current_consumer[i]] <= 0;
-                            controller_state[i] <= IDLE;
+                    end else begin
+                        for (int k = 0; k < NUM_CONSUMERS; k = k + 1) begin
+                            int j = (next_consumer + k) % NUM_CONSUMERS;
+                            if (consumer_pending[j]) begin
+                                chosen_consumer = j;
+                                next_consumer = (j + 1) % NUM_CONSUMERS;
+                                break;
+                            end
                         end
                     end
-                    default: begin
-                        // Should never reach this state
-                        $error("Invalid state %d for channel %d", controller_state[i], i);
-                        controller_state[i] <= IDLE;
+                end
+
+                if (chosen_consumer != -1) begin
+                    channel_serving_consumer[chosen_consumer] = 1;
+                    outstanding = outstanding + 1;
+
+                    if (consumer_read_valid[chosen_consumer]) begin
+                        mem_read_valid[i] <= 1;
+                        mem_read_address[i] <= consumer_read_address[chosen_consumer];
+                        mem_read_tag[i] <= mem_tag_t'(chosen_consumer);
+                        mem_read_atomic_op[i] <= WRITE_ENABLE == 1 ? consumer_read_atomic_op[chosen_consumer] : ATOMIC_NONE;
+                        mem_read_atomic_operand[i] <= consumer_read_atomic_operand[chosen_consumer];
+                        mem_read_atomic_compare[i] <= consumer_read_atomic_compare[chosen_consumer];
+
+                        // Other consumers reading the same address share this request
+                        if (MERGE_READS == 1) begin
+                            for (int j = 0; j < NUM_CONSUMERS; j = j + 1) begin
+                                if (can_merge(j, chosen_consumer)) begin
+                                    channel_serving_consumer[j] = 1;
+                                    consumer_merged[j] = 1;
+                                    consumer_merge_leader[j] = chosen_consumer;
+                                    num_merged = num_merged + 1;
+                                end
+                            end
+                        end
+                    end else begin
+                        mem_write_valid[i] <= 1;
+                        mem_write_address[i] <= consumer_write_address[chosen_consumer];
+                        mem_write_data[i] <= consumer_write_data[chosen_consumer];
+                        mem_write_tag[i] <= mem_tag_t'(chosen_consumer);
                     end
-                endcase
+                end
+
+                outstanding_requests[i] <= outstanding;
+            end
+
+            for (int j = 0; j < NUM_CONSUMERS; j = j + 1) begin
+                // Wait until consumer acknowledges it received response, then reset
+                if (consumer_read_ready[j] && !consumer_read_valid[j]) begin
+                    channel_serving_consumer[j] = 0;
+                    consumer_read_ready[j] <= 0;
+                end
+                if (consumer_write_ready[j] && !consumer_write_valid[j]) begin
+                    channel_serving_consumer[j] = 0;
+                    consumer_write_ready[j] <= 0;
+                end
+
+                // Consumers whose request was not picked up by any channel keep waiting
+                if ((consumer_read_valid[j] || ((WRITE_ENABLE == 1) && consumer_write_valid[j])) && !channel_serving_consumer[j]) begin
+                    consumer_wait_age[j] <= consumer_wait_age[j] + 1;
+                    consumer_wait_cycles[j] <= consumer_wait_cycles[j] + 1;
+                end else begin
+                    consumer_wait_age[j] <= 0;
+                end
             end
+
+            merged_reads <= merged_reads + data_t'(num_merged);
         end
     end
 endmodule
@@ -25,14 +25,23 @@ module reg_file #(
     input logic [4:0] decoded_rd_address,           // Destination register index
     input logic [4:0] decoded_rs1_address,          // Source register 1 index
     input logic [4:0] decoded_rs2_address,          // Source register 2 index
+    input logic [4:0] decoded_rs3_address,          // Source register 3 index
 
-    // Inputs from ALU and LSU per thread
+    // Second write port for loads completing after the warp moved on, independent of the warp being scheduled
+    input logic writeback_enable,
+    input logic [4:0] writeback_rd_address,
+    input logic [THREADS_PER_WARP-1:0] writeback_thread_enable,
+
+    // Inputs from ALU, LSU, shared memory and the cross-lane unit per thread
     input data_t alu_out      [THREADS_PER_WARP],
     input data_t lsu_out      [THREADS_PER_WARP],
+    input data_t shared_memory_out [THREADS_PER_WARP],
+    input data_t shuffle_out  [THREADS_PER_WARP],
 
     // Outputs per thread
     output data_t rs1         [THREADS_PER_WARP],
-    output data_t rs2         [THREADS_PER_WARP]
+    output data_t rs2         [THREADS_PER_WARP],
+    output data_t rs3         [THREADS_PER_WARP]
 );
 
 // Special-purpose register indices
@@ -64,19 +73,23 @@ always @(posedge clk) begin
                 registers[i][j] <= {DATA_WIDTH{1'b0}};
             end
         end
-    end else if (enable) begin
+    end else begin
+        // The identity registers follow the block running on the warp, even before the warp is first scheduled
         for (int i = 0; i < THREADS_PER_WARP; i++) begin
             registers[i][ZERO_REG]     <= {DATA_WIDTH{1'b0}};
             registers[i][THREAD_ID_REG]<= thread_ids[i];
             registers[i][BLOCK_ID_REG] <= block_id;
             registers[i][BLOCK_SIZE_REG]<= block_size;
         end
+    end
 
+    if (!reset && enable) begin
         for (int i = 0; i < THREADS_PER_WARP; i++) begin
             if (thread_enable[i]) begin
                 if (warp_state == WARP_REQUEST) begin
                     rs1[i] <= registers[i][decoded_rs1_address];
                     rs2[i] <= registers[i][decoded_rs2_address];
+                    rs3[i] <= registers[i][decoded_rs3_address];
                 end
 
                 if (warp_state == WARP_UPDATE) begin
@@ -88,6 +101,8 @@ always @(posedge clk) begin
                                 //$display("Writing to register %0d: %0d", decoded_rd_address, alu_out[i]);
                             end
                             LSU_OUT: registers[i][decoded_rd_address] <= lsu_out[i];
+                            SHARED_MEMORY_OUT: registers[i][decoded_rd_address] <= shared_memory_out[i];
+                            SHUFFLE_OUT: registers[i][decoded_rd_address] <= shuffle_out[i];
                             IMMEDIATE: registers[i][decoded_rd_address] <= decoded_immediate;
                             VECTOR_TO_SCALAR: begin
                                 // noop
@@ -99,5 +114,14 @@ always @(posedge clk) begin
             end
         end
     end
+
+    // The scoreboard keeps the warp from writing the same register in WARP_UPDATE
+    if (!reset && writeback_enable && writeback_rd_address >= 4) begin
+        for (int i = 0; i < THREADS_PER_WARP; i++) begin
+            if (writeback_thread_enable[i]) begin
+                registers[i][writeback_rd_address] <= lsu_out[i];
+            end
+        end
+    end
 end
 endmodule
@@ -8,6 +8,7 @@ module scalar_reg_file #(
 ) (
     input wire clk,
     input wire reset,
+    input wire relaunch, // The warp starts the next block, restore the execution mask
     input wire enable, // Warp enable signal
 
     output data_t warp_execution_mask,
@@ -21,6 +22,11 @@ module scalar_reg_file #(
     input logic [4:0] decoded_rd_address,           // Destination register index
     input logic [4:0] decoded_rs1_address,          // Source register 1 index
     input logic [4:0] decoded_rs2_address,          // Source register 2 index
+    input logic [4:0] decoded_rs3_address,          // Source register 3 index
+
+    // Second write port for loads completing after the warp moved on, independent of the warp being scheduled
+    input logic writeback_enable,
+    input logic [4:0] writeback_rd_address,
 
     input data_t alu_out,
     input data_t lsu_out,
@@ -28,7 +34,8 @@ module scalar_reg_file #(
     input data_t vector_to_scalar_data,
 
     output data_t rs1,
-    output data_t rs2
+    output data_t rs2,
+    output data_t rs3
 );
 
 // Special-purpose register indices
@@ -47,10 +54,13 @@ always @(posedge clk) begin
         for (int i = 2; i < 32; i++) begin
             registers[i] <= {DATA_WIDTH{1'b0}};
         end
+    end else if (relaunch) begin
+        registers[1] <= {DATA_WIDTH{1'b1}};
     end else if (enable) begin
         if (warp_state == WARP_REQUEST) begin
             rs1 <= registers[decoded_rs1_address];
             rs2 <= registers[decoded_rs2_address];
+            rs3 <= registers[decoded_rs3_address];
         end
 
         if (warp_state == WARP_UPDATE) begin
@@ -70,6 +80,11 @@ always @(posedge clk) begin
             end
         end
     end
+
+    // The scoreboard keeps the warp from writing the same register in WARP_UPDATE
+    if (!reset && writeback_enable && writeback_rd_address > 0) begin
+        registers[writeback_rd_address] <= lsu_out;
+    end
 end
 
 endmodule
@@ -0,0 +1,88 @@
+`default_nettype none
+`timescale 1ns/1ns
+
+`include "common.sv"
+
+// SHARED MEMORY
+// > Per core scratchpad, read and written by the lws / sws instructions of the warps of the core
+// > Words are interleaved over NUM_BANKS banks (bank = address % NUM_BANKS), each bank serves one word per cycle
+// > The lanes of a warp are served in the same cycle as long as they access different banks, lanes accessing the same
+//   word share the access (a read is broadcast, of several writes the highest lane wins)
+// > Lanes accessing different words of the same bank conflict, they are served one word per bank and cycle
+// > A request is held until done, and has to be dropped for a cycle before the next one starts
+module shared_memory #(
+    parameter int THREADS_PER_WARP = 32,    // Number of lanes accessing the scratchpad at once
+    parameter int SIZE = 1024,              // Number of words
+    parameter int NUM_BANKS = 32            // Number of words that can be accessed in the same cycle
+) (
+    input wire clk,
+    input wire reset,
+
+    // Warp access
+    input wire request_valid,
+    input wire write_enable,
+    input logic [THREADS_PER_WARP-1:0] thread_enable,
+    input data_t address [THREADS_PER_WARP],       // Word address, below SIZE
+    input data_t write_data [THREADS_PER_WARP],
+    output data_t read_data [THREADS_PER_WARP],
+    output logic done,                              // Every enabled lane was served
+
+    // Statistics, per cycle
+    output logic access_started,                    // A warp access started
+    output logic bank_conflict                      // Some lanes had to wait for their bank, the access takes another cycle
+);
+
+data_t memory [SIZE];
+
+logic busy;
+logic [THREADS_PER_WARP-1:0] pending;   // Lanes not served yet
+
+always @(posedge clk) begin
+    if (reset) begin
+        busy <= 0;
+        done <= 0;
+        pending <= 0;
+        access_started <= 0;
+        bank_conflict <= 0;
+    end else begin
+        access_started <= 0;
+        bank_conflict <= 0;
+
+        if (!request_valid) begin
+            busy <= 0;
+            done <= 0;
+        end else if (!done) begin
+            // Each bank serves the word of the first lane waiting for it, and every other lane accessing that word
+            logic [THREADS_PER_WARP-1:0] remaining;
+            logic [NUM_BANKS-1:0] bank_used;
+            data_t bank_address [NUM_BANKS];
+            remaining = busy ? pending : thread_enable;
+            bank_used = 0;
+            for (int i = 0; i < THREADS_PER_WARP; i++) begin
+                if (remaining[i]) begin
+                    int bank;
+                    bank = address[i] % NUM_BANKS;
+                    if (!bank_used[bank]) begin
+                        bank_used[bank] = 1;
+                        bank_address[bank] = address[i];
+                    end
+                    if (bank_address[bank] == address[i]) begin
+                        remaining[i] = 0;
+                        if (write_enable) begin
+                            memory[address[i]] <= write_data[i];
+                        end else begin
+                            read_data[i] <= memory[address[i]];
+                        end
+                    end
+                end
+            end
+
+            busy <= 1;
+            pending <= remaining;
+            done <= remaining == 0;
+            access_started <= !busy;
+            bank_conflict <= remaining != 0;
+        end
+    end
+end
+endmodule
@@ -0,0 +1,244 @@
+`default_nettype none
+`timescale 1ns/1ns
+
+`include "common.sv"
+
+// WRITE BUFFER
+// > Per core buffer between the LSUs and the data cache (or the data memory controller)
+// > Stores are posted: they are acknowledged as soon as the buffer holds them, and drained to memory in the background
+// > A store to an address that is still buffered and not yet draining overwrites the buffered data
+// > A store to an address whose previous store is draining waits, so stores to an address reach memory in order
+// > Loads of a buffered address are held back until the store landed, so a core always reads its own stores
+// > Atomics are loads as far as the buffer is concerned, they pass through once no store to their address is buffered
+// > Each consumer port has a matching memory port, the drain uses whichever memory ports are free
+// > Write combining: a store is held for COMBINE_WINDOW cycles so later stores to the same word replace it instead of
+//   reaching memory separately. It drains early when the buffer runs low on free entries, when a load reads its address,
+//   or when the core flushes the stores of a block slot at the end of its block
+// > Every store is tagged with the block slot that posted it, so each slot is flushed and waits for its own stores only.
+//   A store that overwrites a buffered one takes over its tag, as only the later data reaches memory
+// > Stores to the same line drain together, so the data cache serves adjacent words with a single lookup
+module write_buffer #(
+    parameter int NUM_CONSUMERS = 33,       // Number of LSUs served by this buffer
+    parameter int DEPTH = 64,               // Number of stores the buffer holds
+    parameter int COMBINE_WINDOW = 16,      // Number of cycles a store waits for later stores to the same word (0 = drain at once)
+    parameter int LINE_SIZE = 4,            // Number of words drained together with a store to the same line
+    parameter int NUM_SLOTS = 1             // Number of block slots the stores are tagged with
+) (
+    input wire clk,
+    input wire reset,
+
+    // Consumer Interface (LSUs)
+    input wire [NUM_CONSUMERS-1:0] consumer_read_valid,
+    input data_memory_address_t consumer_read_address [NUM_CONSUMERS],
+    input atomic_op_t consumer_read_atomic_op [NUM_CONSUMERS],
+    input data_t consumer_read_atomic_operand [NUM_CONSUMERS],
+    input data_t consumer_read_atomic_compare [NUM_CONSUMERS],
+    output logic [NUM_CONSUMERS-1:0] consumer_read_ready,
+    output data_t consumer_read_data [NUM_CONSUMERS],
+    input wire [NUM_CONSUMERS-1:0] consumer_write_valid,
+    input data_memory_address_t consumer_write_address [NUM_CONSUMERS],
+    input data_t consumer_write_data [NUM_CONSUMERS],
+    output logic [NUM_CONSUMERS-1:0] consumer_write_ready,
+    input data_t consumer_write_slot,       // Block slot of the warp driving the consumers
+
+    // Memory Interface (Data Cache / Data Memory Controller)
+    output logic [NUM_CONSUMERS-1:0] mem_read_valid,
+    output data_memory_address_t mem_read_address [NUM_CONSUMERS],
+    output atomic_op_t mem_read_atomic_op [NUM_CONSUMERS],
+    output data_t mem_read_atomic_operand [NUM_CONSUMERS],
+    output data_t mem_read_atomic_compare [NUM_CONSUMERS],
+    input wire [NUM_CONSUMERS-1:0] mem_read_ready,
+    input data_t mem_read_data [NUM_CONSUMERS],
+    output logic [NUM_CONSUMERS-1:0] mem_write_valid,
+    output data_memory_address_t mem_write_address [NUM_CONSUMERS],
+    output data_t mem_write_data [NUM_CONSUMERS],
+    input wire [NUM_CONSUMERS-1:0] mem_write_ready,
+
+    input wire [NUM_SLOTS-1:0] flush,       // Drain every buffered store of the slot without waiting for the combining window
+    output logic [NUM_SLOTS-1:0] empty,     // Every store posted by the slot reached memory
+
+    // Statistics, per cycle
+    output data_t posted_stores,            // Number of stores accepted
+    output data_t drained_stores            // Number of stores sent to memory, posted_stores / drained_stores is the combining efficiency
+);
+
+localparam int LINE_SHIFT = $clog2(LINE_SIZE);
+
+// Buffered stores, updated with blocking assignments so that entries freed or filled earlier in the cycle can be reused
+logic [DEPTH-1:0] entry_valid;
+logic [DEPTH-1:0] entry_draining;
+data_memory_address_t entry_address [DEPTH];
+data_t entry_data [DEPTH];
+int entry_age [DEPTH];
+data_t entry_slot [DEPTH];
+
+// Drain ports
+cache_port_state_t port_state [NUM_CONSUMERS];
+int port_entry [NUM_CONSUMERS];
+
+always_comb begin
+    empty = {NUM_SLOTS{1'b1}};
+    for (int j = 0; j < DEPTH; j++) begin
+        if (entry_valid[j]) begin
+            empty[entry_slot[j]] = 0;
+        end
+    end
+end
+
+// Loads pass through, unless they read an address with a buffered store
+always_comb begin
+    for (int i = 0; i < NUM_CONSUMERS; i++) begin
+        logic buffered;
+        buffered = 0;
+        for (int j = 0; j < DEPTH; j++) begin
+            if (entry_valid[j] && entry_address[j] == consumer_read_address[i]) begin
+                buffered = 1;
+            end
+        end
+        mem_read_valid[i] = consumer_read_valid[i] && !buffered;
+        mem_read_address[i] = consumer_read_address[i];
+        mem_read_atomic_op[i] = consumer_read_atomic_op[i];
+        mem_read_atomic_operand[i] = consumer_read_atomic_operand[i];
+        mem_read_atomic_compare[i] = consumer_read_atomic_compare[i];
+        consumer_read_ready[i] = mem_read_ready[i];
+        consumer_read_data[i] = mem_read_data[i];
+    end
+end
+
+always @(posedge clk) begin
+    if (reset) begin
+        for (int i = 0; i < NUM_CONSUMERS; i++) begin
+            consumer_write_ready[i] <= 0;
+            mem_write_valid[i] <= 0;
+            mem_write_address[i] <= 0;
+            mem_write_data[i] <= 0;
+            port_state[i] <= PORT_IDLE;
+        end
+        entry_valid = 0;
+        entry_draining = 0;
+        posted_stores <= 0;
+        drained_stores <= 0;
+    end else begin
+        int next_port = 0;
+        logic full = 0;
+        data_t num_posted = 0;
+        data_t num_drained = 0;
+        logic [DEPTH-1:0] drain_entry;
+        logic [DEPTH-1:0] drain_line;
+
+        // Drained stores free their entry once memory accepted them
+        for (int i = 0; i < NUM_CONSUMERS; i++) begin
+            case (port_state[i])
+                PORT_REQUESTING: begin
+                    if (mem_write_ready[i]) begin
+                        mem_write_valid[i] <= 0;
+                        entry_valid[port_entry[i]] = 0;
+                        entry_draining[port_entry[i]] = 0;
+                        port_state[i] <= PORT_RELEASING;
+                    end
+                end
+                PORT_RELEASING: begin
+                    if (!mem_write_ready[i]) begin
+                        port_state[i] <= PORT_IDLE;
+                    end
+                end
+                default: begin
+                end
+            endcase
+        end
+
+        // Accept new stores
+        for (int i = 0; i < NUM_CONSUMERS; i++) begin
+            // Wait until the consumer acknowledges it received the response, then reset
+            if (consumer_write_ready[i] && !consumer_write_valid[i]) begin
+                consumer_write_ready[i] <= 0;
+            end
+
+            if (consumer_write_valid[i] && !consumer_write_ready[i]) begin
+                int match = -1;
+                int free = -1;
+                for (int j = 0; j < DEPTH; j++) begin
+                    if (entry_valid[j] && entry_address[j] == consumer_write_address[i]) begin
+                        match = j;
+                    end else if (!entry_valid[j] && free == -1) begin
+                        free = j;
+                    end
+                end
+
+                if (match != -1) begin
+                    if (!entry_draining[match]) begin
+                        entry_data[match] = consumer_write_data[i];
+                        entry_slot[match] = consumer_write_slot;
+                        consumer_write_ready[i] <= 1;
+                        num_posted = num_posted + 1;
+                    end
+                end else if (free != -1) begin
+                    entry_valid[free] = 1;
+                    entry_address[free] = consumer_write_address[i];
+                    entry_data[free] = consumer_write_data[i];
+                    entry_age[free] = 0;
+                    entry_slot[free] = consumer_write_slot;
+                    consumer_write_ready[i] <= 1;
+                    num_posted = num_posted + 1;
+                end else begin
+                    full = 1;
+                end
+                // Otherwise the buffer is full, or the previous store to this address is draining
+            end
+        end
+
+        // Choose the stores to drain: those whose combining window ran out, those of a flushed slot,
+        // and all of them when a store found no free entry
+        for (int j = 0; j < DEPTH; j++) begin
+            drain_entry[j] = entry_valid[j] && !entry_draining[j]
+                && (entry_age[j] >= COMBINE_WINDOW || flush[entry_slot[j]] || full);
+            // A held back load waits for this store
+            for (int i = 0; i < NUM_CONSUMERS; i++) begin
+                if (consumer_read_valid[i] && entry_address[j] == consumer_read_address[i]) begin
+                    drain_entry[j] = entry_valid[j] && !entry_draining[j];
+                end
+            end
+        end
+        // Adjacent stores go along with them
+        for (int j = 0; j < DEPTH; j++) begin
+            drain_line[j] = 0;
+            for (int k = 0; k < DEPTH; k++) begin
+                if (drain_entry[k] && (entry_address[k] >> LINE_SHIFT) == (entry_address[j] >> LINE_SHIFT)) begin
+                    drain_line[j] = entry_valid[j] && !entry_draining[j];
+                end
+            end
+        end
+
+        // Hand the chosen stores to the free memory ports
+        for (int j = 0; j < DEPTH; j++) begin
+            if (drain_line[j]) begin
+                while (next_port < NUM_CONSUMERS && port_state[next_port] != PORT_IDLE) begin
+                    next_port = next_port + 1;
+                end
+                if (next_port == NUM_CONSUMERS) begin
+                    break;
+                end
+                entry_draining[j] = 1;
+                port_entry[next_port] <= j;
+                port_state[next_port] <= PORT_REQUESTING;
+                mem_write_valid[next_port] <= 1;
+                mem_write_address[next_port] <= entry_address[j];
+                mem_write_data[next_port] <= entry_data[j];
+                next_port = next_port + 1;
+                num_drained = num_drained + 1;
+            end
+        end
+
+        // Stores that keep waiting age towards the end of their combining window
+        for (int j = 0; j < DEPTH; j++) begin
+            if (entry_valid[j] && !entry_draining[j] && entry_age[j] < COMBINE_WINDOW) begin
+                entry_age[j] = entry_age[j] + 1;
+            end
+        end
+
+        posted_stores <= num_posted;
+        drained_stores <= num_drained;
+    end
+end
+
+endmodule
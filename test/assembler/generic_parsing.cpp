@@ -1,6 +1,7 @@
 #include "instructions.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
+#include "emitter.hpp"
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "assembler_helper.hpp"
 #include "doctest.h"
@@ -198,3 +199,26 @@ TEST_CASE("Labels") {
         REQUIRE_FALSE(program_or_err.has_value());
     }
 }
+
+TEST_CASE("Emitting instructions") {
+    using namespace sim::instructions;
+
+    SUBCASE("Scalar instructions set the scalar bit") {
+        const std::vector<std::string> input = {
+            "s.mul s5, s6, s7",
+            "s.div s5, s6, s7",
+            "mul x5, x6, x7",
+            "halt"
+        };
+
+        auto program_or_err = as::parse_program(input);
+        REQUIRE(program_or_err.has_value());
+
+        const auto machine_code = as::translate_to_binary(program_or_err.value());
+        REQUIRE_EQ(machine_code.size(), 4);
+        REQUIRE_EQ(machine_code[0].bits, mul(5_s, 6_s, 7_s).make_scalar().bits);
+        REQUIRE_EQ(machine_code[1].bits, div(5_s, 6_s, 7_s).make_scalar().bits);
+        REQUIRE_EQ(machine_code[2].bits, mul(5_x, 6_x, 7_x).bits);
+        REQUIRE_EQ(machine_code[3].bits, halt().bits);
+    }
+}
@@ -27,6 +27,12 @@ TEST_CASE("Lexing instructions") {
         {"sra", sim::MnemonicName::SRA},
         {"or", sim::MnemonicName::OR},
         {"and", sim::MnemonicName::AND},
+        {"mul", sim::MnemonicName::MUL},
+        {"mulh", sim::MnemonicName::MULH},
+        {"div", sim::MnemonicName::DIV},
+        {"rem", sim::MnemonicName::REM},
+        {"mac", sim::MnemonicName::MAC},
+        {"dot4", sim::MnemonicName::DOT4},
         {"lb", sim::MnemonicName::LB},
         {"lh", sim::MnemonicName::LH},
         {"lw", sim::MnemonicName::LW},
@@ -41,7 +47,24 @@ TEST_CASE("Lexing instructions") {
         {"bge", sim::MnemonicName::BGE},
         {"halt", sim::MnemonicName::HALT},
         {"sx.slt", sim::MnemonicName::SX_SLT},
-        {"sx.slti", sim::MnemonicName::SX_SLTI}
+        {"sx.slti", sim::MnemonicName::SX_SLTI},
+        {"bar", sim::MnemonicName::BAR},
+        {"sx.redadd", sim::MnemonicName::SX_REDADD},
+        {"sx.redmin", sim::MnemonicName::SX_REDMIN},
+        {"sx.redmax", sim::MnemonicName::SX_REDMAX},
+        {"sx.redand", sim::MnemonicName::SX_REDAND},
+        {"sx.redor", sim::MnemonicName::SX_REDOR},
+        {"shfl", sim::MnemonicName::SHFL},
+        {"split", sim::MnemonicName::SPLIT},
+        {"else", sim::MnemonicName::ELSE},
+        {"join", sim::MnemonicName::JOIN},
+        {"lws", sim::MnemonicName::LWS},
+        {"sws", sim::MnemonicName::SWS},
+        {"amoadd.w", sim::MnemonicName::AMOADD_W},
+        {"amoswap.w", sim::MnemonicName::AMOSWAP_W},
+        {"amomin.w", sim::MnemonicName::AMOMIN_W},
+        {"amomax.w", sim::MnemonicName::AMOMAX_W},
+        {"amocas.w", sim::MnemonicName::AMOCAS_W}
     };
 
     for (const auto &[instr, mnemonic_name] : instructions) {
@@ -262,3 +262,776 @@ TEST_CASE("Conditional execution using mask") {
     }
 
 }
+
+TEST_CASE("Data cache statistics") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    data_mem.push_data(42);
+
+    instruction_mem.push_instruction(lw(5_x, 0_x, 0));   // lw x5, 0(x0)
+    instruction_mem.push_instruction(lw(6_x, 0_x, 0));   // lw x6, 0(x0) (same line, should hit)
+    instruction_mem.push_instruction(sw(1_x, 6_x, 64));  // sw x6, 64(x1)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 1);
+
+    auto done = simulate(top, instruction_mem, data_mem, 5000);
+    REQUIRE(done);
+
+    for(auto i = 0; i < 32; i++) {
+        CHECK(data_mem[64 + i] == 42);
+    }
+
+    // Every load and store is counted exactly once
+    CHECK(top.perf_dcache_hits + top.perf_dcache_misses == 3 * 32);
+    CHECK(top.perf_dcache_hits >= 32);
+
+    // Loads of the same word by all lanes are coalesced into far fewer lookups
+    CHECK(top.perf_dcache_transactions < top.perf_dcache_hits + top.perf_dcache_misses);
+}
+
+TEST_CASE("Instruction cache statistics") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    for (auto i = 0; i < 16; i++) {
+        instruction_mem.push_instruction(addi(5_x, 5_x, 1));
+    }
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 1);
+
+    auto done = simulate(top, instruction_mem, data_mem, 5000);
+    REQUIRE(done);
+
+    // A single warp fetches each of the 17 instructions once, plus at most 4 prefetched past the halt.
+    // Every fetch is either a hit or a miss, a miss is not counted again once its line was filled
+    CHECK(top.perf_icache_hits + top.perf_icache_misses >= 17);
+    CHECK(top.perf_icache_hits + top.perf_icache_misses <= 17 + 4);
+    CHECK(top.perf_icache_misses >= 5);
+}
+
+TEST_CASE("Uniform load broadcast") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    for (auto i = 0u; i < 32; i++) {
+        data_mem.push_data(100 + i);
+    }
+
+    instruction_mem.push_instruction(lw(5_x, 0_x, 3));    // lw x5, 3(x0) (same address in every lane)
+    instruction_mem.push_instruction(lw(6_x, 1_x, 0));    // lw x6, 0(x1) (different address in every lane)
+    instruction_mem.push_instruction(add(7_x, 5_x, 6_x)); // x7 = x5 + x6
+    instruction_mem.push_instruction(sw(1_x, 7_x, 64));   // sw x7, 64(x1)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 1);
+
+    auto done = simulate(top, instruction_mem, data_mem, 5000);
+    REQUIRE(done);
+
+    for(auto i = 0u; i < 32; i++) {
+        CHECK(data_mem[64 + i] == 103 + 100 + i);
+    }
+
+    CHECK(top.perf_uniform_loads == 1);
+}
+
+TEST_CASE("Memory latency with out-of-order responses") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    // Responses take 20 to 35 cycles depending on the address, so they come back out of order
+    data_mem.latency = 20;
+    data_mem.latency_jitter = 15;
+    instruction_mem.latency = 10;
+    instruction_mem.latency_jitter = 5;
+
+    for (auto i = 0u; i < 256; i++) {
+        data_mem.push_data(i * 3);
+    }
+
+    instruction_mem.push_instruction(slli(9_x, 2_x, 6));  // x9 = x2 * 64
+    instruction_mem.push_instruction(add(9_x, 9_x, 1_x)); // x9 = x9 + x1, the global thread id
+    instruction_mem.push_instruction(lw(5_x, 9_x, 0));    // lw x5, 0(x9)
+    instruction_mem.push_instruction(addi(5_x, 5_x, 1));  // x5 = x5 + 1
+    instruction_mem.push_instruction(sw(9_x, 5_x, 512));  // sw x5, 512(x9)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 4, 2);
+
+    auto done = simulate(top, instruction_mem, data_mem, 50000);
+    REQUIRE(done);
+
+    for(auto i = 0u; i < 256; i++) {
+        CHECK(data_mem[512 + i] == i * 3 + 1);
+    }
+}
+
+TEST_CASE("Warps interleave while waiting on memory") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    // Slow memory, so the other warp of each core runs while a load is in flight
+    data_mem.latency = 40;
+    data_mem.latency_jitter = 10;
+
+    for (auto i = 0u; i < 64; i++) {
+        data_mem.push_data(1000 + i);
+    }
+
+    instruction_mem.push_instruction(lw(5_x, 1_x, 0));    // lw x5, 0(x1)
+    instruction_mem.push_instruction(addi(6_x, 1_x, 7));  // x6 = x1 + 7, runs while the other warp waits
+    instruction_mem.push_instruction(add(6_x, 6_x, 6_x)); // x6 = x6 + x6
+    instruction_mem.push_instruction(add(7_x, 5_x, 6_x)); // x7 = x5 + x6
+    instruction_mem.push_instruction(sw(1_x, 7_x, 256));  // sw x7, 256(x1)
+    instruction_mem.push_instruction(lw(8_x, 0_x, 5));    // lw x8, 5(x0) (uniform address)
+    instruction_mem.push_instruction(sw(1_x, 8_x, 512));  // sw x8, 512(x1)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 2);
+
+    auto done = simulate(top, instruction_mem, data_mem, 50000);
+    REQUIRE(done);
+
+    for(auto i = 0u; i < 64; i++) {
+        CHECK(data_mem[256 + i] == 1000 + i + 2 * (i + 7));
+        CHECK(data_mem[512 + i] == 1005);
+    }
+}
+
+TEST_CASE("Scheduler idle cycles") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    // A single warp has nothing to switch to while its load is in flight
+    data_mem.latency = 100;
+
+    instruction_mem.push_instruction(lw(5_x, 1_x, 0));    // lw x5, 0(x1)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 1);
+
+    auto done = simulate(top, instruction_mem, data_mem, 5000);
+    REQUIRE(done);
+
+    CHECK(top.perf_scheduler_idle_cycles >= 100);
+}
+
+TEST_CASE("Prefetched instructions are flushed on jumps") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    // Slow fetches leave the prefetch buffer full of instructions that the jumps skip
+    instruction_mem.latency = 10;
+    instruction_mem.latency_jitter = 5;
+
+    instruction_mem.push_instruction(addi(5_x, 0_x, 1));     // addi x5, x0, 1
+    instruction_mem.push_instruction(jal(10_s, 4));          // jal s10, 4
+    instruction_mem.push_instruction(addi(5_x, 5_x, 100));   // skipped
+    instruction_mem.push_instruction(addi(5_x, 5_x, 100));   // skipped
+    instruction_mem.push_instruction(addi(5_x, 5_x, 2));     // addi x5, x5, 2
+    instruction_mem.push_instruction(sw(1_x, 5_x, 0));       // sw x5, 0(x1)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 2);
+
+    auto done = simulate(top, instruction_mem, data_mem, 5000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 64; i++) {
+        CHECK(data_mem[i] == 3);
+    }
+}
+
+TEST_CASE("Fetches of the same instruction are merged") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    // Both cores miss in their instruction caches on the same lines while the first fill is still in flight
+    instruction_mem.latency = 10;
+
+    instruction_mem.push_instruction(addi(5_x, 2_x, 7));     // addi x5, x2, 7
+    instruction_mem.push_instruction(sw(2_x, 5_x, 0));       // sw x5, 0(x2)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 2, 1);
+
+    auto done = simulate(top, instruction_mem, data_mem, 5000);
+    REQUIRE(done);
+
+    CHECK(data_mem[0] == 7);
+    CHECK(data_mem[1] == 8);
+    CHECK(top.perf_merged_fetches > 0);
+}
+
+TEST_CASE("Instructions issue past pending loads until they need the loaded register") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    data_mem.latency = 50;
+    data_mem.latency_jitter = 10;
+
+    for (auto i = 0u; i < 64; i++) {
+        data_mem.push_data(10 + i);
+    }
+
+    instruction_mem.push_instruction(lw(5_x, 1_x, 0));    // lw x5, 0(x1)
+    instruction_mem.push_instruction(addi(6_x, 0_x, 3));  // x6 = 3, independent of the load
+    instruction_mem.push_instruction(addi(7_x, 5_x, 0));  // x7 = x5, waits for the load
+    instruction_mem.push_instruction(lw(8_x, 1_x, 0));    // lw x8, 0(x1)
+    instruction_mem.push_instruction(addi(8_x, 0_x, 42)); // x8 = 42, must not be overwritten by the load
+    instruction_mem.push_instruction(add(7_x, 7_x, 8_x)); // x7 = x7 + x8
+    instruction_mem.push_instruction(add(7_x, 7_x, 6_x)); // x7 = x7 + x6
+    instruction_mem.push_instruction(sw(1_x, 7_x, 256));  // sw x7, 256(x1)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 2);
+
+    auto done = simulate(top, instruction_mem, data_mem, 50000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 64; i++) {
+        CHECK(data_mem[256 + i] == 10 + i + 42 + 3);
+    }
+}
+
+TEST_CASE("Loads see posted stores of the same core") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    // The stores are still buffered or on their way to memory when the loads are sent
+    data_mem.latency = 50;
+    data_mem.latency_jitter = 10;
+
+    instruction_mem.push_instruction(addi(5_x, 1_x, 20));  // x5 = x1 + 20
+    instruction_mem.push_instruction(sw(1_x, 5_x, 256));   // sw x5, 256(x1)
+    instruction_mem.push_instruction(addi(5_x, 5_x, 1));   // x5 = x5 + 1
+    instruction_mem.push_instruction(sw(1_x, 5_x, 256));   // sw x5, 256(x1), overwrites the first store
+    instruction_mem.push_instruction(lw(6_x, 1_x, 256));   // lw x6, 256(x1)
+    instruction_mem.push_instruction(sw(1_x, 6_x, 512));   // sw x6, 512(x1)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 2);
+
+    auto done = simulate(top, instruction_mem, data_mem, 50000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 64; i++) {
+        CHECK(data_mem[256 + i] == i + 21);
+        CHECK(data_mem[512 + i] == i + 21);
+    }
+}
+
+TEST_CASE("Stores to the same word are combined before they reach memory") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    instruction_mem.push_instruction(addi(5_x, 1_x, 30));  // x5 = x1 + 30
+    instruction_mem.push_instruction(sw(1_x, 5_x, 256));   // sw x5, 256(x1)
+    instruction_mem.push_instruction(addi(5_x, 5_x, 1));   // x5 = x5 + 1
+    instruction_mem.push_instruction(sw(1_x, 5_x, 256));   // sw x5, 256(x1), replaces the buffered store
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 2);
+
+    auto done = simulate(top, instruction_mem, data_mem, 50000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 64; i++) {
+        CHECK(data_mem[256 + i] == i + 31);
+    }
+    CHECK(top.perf_posted_stores == 128);
+    CHECK(top.perf_drained_stores < top.perf_posted_stores);
+}
+
+TEST_CASE("Small blocks share a core") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    data_mem.latency = 20;
+
+    instruction_mem.push_instruction(slli(9_x, 2_x, 5));   // x9 = x2 * 32
+    instruction_mem.push_instruction(add(9_x, 9_x, 1_x));  // x9 = x9 + x1 (global thread id)
+    instruction_mem.push_instruction(addi(5_x, 2_x, 100)); // x5 = x2 + 100
+    instruction_mem.push_instruction(sw(9_x, 5_x, 256));   // sw x5, 256(x9)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 6, 1); // 6 blocks of 1 warp, more than one block per core
+
+    auto done = simulate(top, instruction_mem, data_mem, 50000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 6 * 32; i++) {
+        CHECK(data_mem[256 + i] == i / 32 + 100);
+    }
+}
+
+TEST_CASE("Relaunched blocks start with a full execution mask") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    instruction_mem.push_instruction(slli(9_x, 2_x, 5));       // x9 = x2 * 32
+    instruction_mem.push_instruction(add(9_x, 9_x, 1_x));      // x9 = x9 + x1 (global thread id)
+    instruction_mem.push_instruction(addi(5_x, 2_x, 1));       // x5 = x2 + 1
+    instruction_mem.push_instruction(sw(9_x, 5_x, 256));       // sw x5, 256(x9), every lane of every block
+    instruction_mem.push_instruction(sx_slti(1_x, 1_x, 3));    // s1 = (x1 < 3) ? 1 : 0
+    instruction_mem.push_instruction(addi(6_x, 0_x, 7));       // x6 = 7
+    instruction_mem.push_instruction(sw(9_x, 6_x, 1024));      // sw x6, 1024(x9), only the first three lanes
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 8, 1); // 8 blocks of 1 warp, each slot runs several blocks
+
+    auto done = simulate(top, instruction_mem, data_mem, 50000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 8 * 32; i++) {
+        CHECK(data_mem[256 + i] == i / 32 + 1);
+        CHECK(data_mem[1024 + i] == (i % 32 < 3 ? 7u : 0u));
+    }
+}
+
+TEST_CASE("Shared memory loads and stores with bank conflicts") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    instruction_mem.push_instruction(slli(9_x, 2_x, 5));       // x9 = x2 * 32
+    instruction_mem.push_instruction(add(9_x, 9_x, 1_x));      // x9 = x9 + x1 (global thread id)
+    instruction_mem.push_instruction(addi(5_x, 9_x, 10));      // x5 = x9 + 10
+    instruction_mem.push_instruction(sws(1_x, 5_x, 0));        // sws x5, 0(x1), one word per bank
+    instruction_mem.push_instruction(xori(6_x, 1_x, 31));      // x6 = 31 - x1
+    instruction_mem.push_instruction(lws(7_x, 6_x, 0));        // lws x7, 0(x6), the value of the mirrored lane
+    instruction_mem.push_instruction(sw(9_x, 7_x, 256));       // sw x7, 256(x9)
+    instruction_mem.push_instruction(slli(8_x, 1_x, 4));       // x8 = x1 * 16, 16 different words in each of 2 banks
+    instruction_mem.push_instruction(sws(8_x, 9_x, 1));        // sws x9, 1(x8)
+    instruction_mem.push_instruction(lws(10_x, 8_x, 1));       // lws x10, 1(x8)
+    instruction_mem.push_instruction(sw(9_x, 10_x, 1024));     // sw x10, 1024(x9)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 4, 1); // 4 blocks of 1 warp, blocks on the same core use separate parts of the scratchpad
+
+    auto done = simulate(top, instruction_mem, data_mem, 50000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 4 * 32; i++) {
+        CHECK(data_mem[256 + i] == (i / 32) * 32 + (31 - i % 32) + 10);
+        CHECK(data_mem[1024 + i] == i);
+    }
+    CHECK(top.perf_shared_memory_accesses == 4 * 4);
+    CHECK(top.perf_shared_memory_bank_conflicts == 4 * 2 * 15); // The strided accesses take 16 cycles instead of 1
+}
+
+TEST_CASE("A block alone on its core uses the whole scratchpad") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    instruction_mem.push_instruction(slli(9_x, 2_x, 6));       // x9 = x2 * 64
+    instruction_mem.push_instruction(add(9_x, 9_x, 1_x));      // x9 = x9 + x1 (global thread id)
+    instruction_mem.push_instruction(addi(5_x, 9_x, 10));      // x5 = x9 + 10
+    instruction_mem.push_instruction(addi(6_x, 9_x, 20));      // x6 = x9 + 20
+    instruction_mem.push_instruction(sws(1_x, 5_x, 0));        // sws x5, 0(x1)
+    instruction_mem.push_instruction(sws(1_x, 6_x, 512));      // sws x6, 512(x1), past the part of a block when two share the core
+    instruction_mem.push_instruction(lws(7_x, 1_x, 0));        // lws x7, 0(x1)
+    instruction_mem.push_instruction(lws(8_x, 1_x, 512));      // lws x8, 512(x1)
+    instruction_mem.push_instruction(sw(9_x, 7_x, 1024));      // sw x7, 1024(x9)
+    instruction_mem.push_instruction(sw(9_x, 8_x, 1536));      // sw x8, 1536(x9)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 4, 2); // 4 blocks of 2 warps, only one block fits on a core at once
+
+    auto done = simulate(top, instruction_mem, data_mem, 50000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 4 * 64; i++) {
+        CHECK(data_mem[1024 + i] == i + 10);
+        CHECK(data_mem[1536 + i] == i + 20);
+    }
+}
+
+TEST_CASE("Warps of a block wait for each other at a barrier") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    // The loads finish at different times for every address, so the warps reach the barrier at different times
+    data_mem.latency = 10;
+    data_mem.latency_jitter = 40;
+    for (auto i = 0u; i < 4 * 64; i++) {
+        data_mem[1024 + i] = i * 5 + 3;
+    }
+
+    instruction_mem.push_instruction(slli(9_x, 2_x, 6));       // x9 = x2 * 64
+    instruction_mem.push_instruction(add(9_x, 9_x, 1_x));      // x9 = x9 + x1 (global thread id)
+    instruction_mem.push_instruction(lw(5_x, 9_x, 1024));      // lw x5, 1024(x9)
+    instruction_mem.push_instruction(sws(1_x, 5_x, 0));        // sws x5, 0(x1)
+    instruction_mem.push_instruction(bar());                   // wait for the other warp of the block
+    instruction_mem.push_instruction(xori(6_x, 1_x, 32));      // x6 = the same lane in the other warp
+    instruction_mem.push_instruction(lws(7_x, 6_x, 0));        // lws x7, 0(x6)
+    instruction_mem.push_instruction(sw(9_x, 7_x, 256));       // sw x7, 256(x9)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 4, 2); // 4 blocks of 2 warps
+
+    auto done = simulate(top, instruction_mem, data_mem, 50000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 4 * 64; i++) {
+        CHECK(data_mem[256 + i] == (i ^ 32u) * 5 + 3);
+    }
+    CHECK(top.perf_barrier_wait_cycles > 0);
+}
+
+TEST_CASE("Atomic memory operations from every thread") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    data_mem.latency = 5;
+    data_mem.latency_jitter = 20;
+    data_mem[301] = 1000;
+
+    instruction_mem.push_instruction(slli(9_x, 2_x, 6));           // x9 = x2 * 64
+    instruction_mem.push_instruction(add(9_x, 9_x, 1_x));          // x9 = x9 + x1 (global thread id)
+    instruction_mem.push_instruction(addi(8_x, 0_x, 1));           // x8 = 1
+    instruction_mem.push_instruction(addi(10_x, 9_x, 1));          // x10 = x9 + 1
+    instruction_mem.push_instruction(addi(12_x, 0_x, 100));
+    instruction_mem.push_instruction(amoadd_w(5_x, 12_x, 8_x));    // amoadd.w x5, x8, (x12)
+    instruction_mem.push_instruction(sw(9_x, 5_x, 1024));          // sw x5, 1024(x9)
+    instruction_mem.push_instruction(andi(13_x, 9_x, 7));
+    instruction_mem.push_instruction(addi(13_x, 13_x, 200));       // x13 = 200 + x9 % 8
+    instruction_mem.push_instruction(amoadd_w(0_x, 13_x, 9_x));    // amoadd.w x0, x9, (x13)
+    instruction_mem.push_instruction(addi(12_x, 0_x, 300));
+    instruction_mem.push_instruction(amomax_w(0_x, 12_x, 9_x));    // amomax.w x0, x9, (x12)
+    instruction_mem.push_instruction(addi(12_x, 0_x, 301));
+    instruction_mem.push_instruction(amomin_w(0_x, 12_x, 9_x));    // amomin.w x0, x9, (x12)
+    instruction_mem.push_instruction(addi(12_x, 0_x, 302));
+    instruction_mem.push_instruction(addi(11_x, 0_x, 0));          // x11 = 0, the value amocas.w expects
+    instruction_mem.push_instruction(amocas_w(11_x, 12_x, 10_x));  // amocas.w x11, x10, (x12)
+    instruction_mem.push_instruction(sw(9_x, 11_x, 1536));         // sw x11, 1536(x9)
+    instruction_mem.push_instruction(addi(12_x, 0_x, 303));
+    instruction_mem.push_instruction(amoswap_w(14_x, 12_x, 10_x)); // amoswap.w x14, x10, (x12)
+    instruction_mem.push_instruction(sw(9_x, 14_x, 512));          // sw x14, 512(x9)
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 4, 2); // 4 blocks of 2 warps, on both cores
+
+    auto done = simulate(top, instruction_mem, data_mem, 100000);
+    REQUIRE(done);
+
+    constexpr auto num_threads = 4u * 64u;
+
+    // Every increment saw a different counter value
+    CHECK(data_mem[100] == num_threads);
+    auto seen = std::vector<bool>(num_threads, false);
+    for (auto i = 0u; i < num_threads; i++) {
+        auto old_value = data_mem[1024 + i];
+        REQUIRE(old_value < num_threads);
+        CHECK_FALSE(seen[old_value]);
+        seen[old_value] = true;
+    }
+
+    for (auto bucket = 0u; bucket < 8; bucket++) {
+        auto expected = 0u;
+        for (auto i = bucket; i < num_threads; i += 8) {
+            expected += i;
+        }
+        CHECK(data_mem[200 + bucket] == expected);
+    }
+
+    CHECK(data_mem[300] == num_threads - 1);
+    CHECK(data_mem[301] == 0);
+
+    // A single thread found the initial value, all others found the value it wrote
+    auto winners = 0u;
+    for (auto i = 0u; i < num_threads; i++) {
+        if (data_mem[1536 + i] == 0) {
+            winners++;
+        } else {
+            CHECK(data_mem[1536 + i] == data_mem[302]);
+        }
+    }
+    CHECK(winners == 1);
+    CHECK(data_mem[302] != 0);
+
+    // The swaps form a chain, every value was read back by exactly one thread or is still in memory
+    auto swapped = std::vector<bool>(num_threads + 1, false);
+    swapped[data_mem[303]] = true;
+    for (auto i = 0u; i < num_threads; i++) {
+        auto old_value = data_mem[512 + i];
+        REQUIRE(old_value <= num_threads);
+        CHECK_FALSE(swapped[old_value]);
+        swapped[old_value] = true;
+    }
+}
+
+TEST_CASE("Warp reductions and shuffles") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    instruction_mem.push_instruction(slli(5_x, 1_x, 1));
+    instruction_mem.push_instruction(add(5_x, 5_x, 1_x));
+    instruction_mem.push_instruction(addi(5_x, 5_x, 1));                  // x5 = x1 * 3 + 1
+    instruction_mem.push_instruction(addi(6_x, 0_x, 40));
+    instruction_mem.push_instruction(sub(7_x, 1_x, 6_x));                 // x7 = x1 - 40
+    instruction_mem.push_instruction(sx_redmin(7_s, 1_x));                // s7 = first thread id of the warp
+    instruction_mem.push_instruction(sx_redadd(5_s, 5_x));                // sx.redadd s5, x5
+    instruction_mem.push_instruction(sx_redmin(6_s, 7_x));                // sx.redmin s6, x7
+    instruction_mem.push_instruction(sx_redmax(8_s, 7_x));                // sx.redmax s8, x7
+    instruction_mem.push_instruction(sx_redand(9_s, 5_x));                // sx.redand s9, x5
+    instruction_mem.push_instruction(sx_redor(10_s, 5_x));                // sx.redor s10, x5
+    instruction_mem.push_instruction(sw(7_s, 5_s, 512).make_scalar());    // s.sw s5, 512(s7)
+    instruction_mem.push_instruction(sw(7_s, 6_s, 640).make_scalar());
+    instruction_mem.push_instruction(sw(7_s, 8_s, 768).make_scalar());
+    instruction_mem.push_instruction(sw(7_s, 9_s, 896).make_scalar());
+    instruction_mem.push_instruction(sw(7_s, 10_s, 1024).make_scalar());
+    instruction_mem.push_instruction(addi(11_x, 1_x, 1));
+    instruction_mem.push_instruction(shfl(10_x, 5_x, 11_x));              // x10 = x5 of the next lane
+    instruction_mem.push_instruction(addi(12_x, 0_x, 5));
+    instruction_mem.push_instruction(shfl(13_x, 5_x, 12_x));              // x13 = x5 of lane 5
+    instruction_mem.push_instruction(sw(1_x, 10_x, 1280));
+    instruction_mem.push_instruction(sw(1_x, 13_x, 1408));
+    instruction_mem.push_instruction(sx_slti(1_s, 1_x, 40));              // s1 = x1 < 40
+    instruction_mem.push_instruction(sx_redadd(11_s, 5_x));               // Only the active lanes are summed up
+    instruction_mem.push_instruction(sw(7_s, 11_s, 1152).make_scalar());
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 2);
+
+    auto done = simulate(top, instruction_mem, data_mem, 10000);
+    REQUIRE(done);
+
+    for (auto warp = 0u; warp < 2; warp++) {
+        const auto base = warp * 32;
+        auto sum = IData{0};
+        auto active_sum = IData{0};
+        auto all_and = ~IData{0};
+        auto all_or = IData{0};
+        for (auto i = base; i < base + 32; i++) {
+            const auto value = i * 3 + 1;
+            sum += value;
+            all_and &= value;
+            all_or |= value;
+            if (i < 40) {
+                active_sum += value;
+            }
+        }
+        CHECK(data_mem[512 + base] == sum);
+        CHECK(data_mem[640 + base] == (IData)(base - 40));
+        CHECK(data_mem[768 + base] == (IData)(base + 31 - 40));
+        CHECK(data_mem[896 + base] == all_and);
+        CHECK(data_mem[1024 + base] == all_or);
+        CHECK(data_mem[1152 + base] == active_sum);
+
+        for (auto lane = 0u; lane < 32; lane++) {
+            CHECK(data_mem[1280 + base + lane] == (base + (lane + 1) % 32) * 3 + 1);
+            CHECK(data_mem[1408 + base + lane] == (base + 5) * 3 + 1);
+        }
+    }
+}
+
+TEST_CASE("Divergent regions with the mask stack") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    // Scalar stores are not masked, they mark which paths a warp went through
+    instruction_mem.push_instruction(sx_redmin(7_s, 1_x));                // s7 = first thread id of the warp
+    instruction_mem.push_instruction(addi(8_s, 0_s, 1).make_scalar());    // s8 = 1
+    instruction_mem.push_instruction(sx_slti(2_s, 1_x, 40));              // s2 = x1 < 40
+    instruction_mem.push_instruction(split(2_s, 8));                      // split s2, else
+    instruction_mem.push_instruction(addi(5_x, 0_x, 1));                  //     x5 = 1
+    instruction_mem.push_instruction(sw(7_s, 8_s, 1024).make_scalar());
+    instruction_mem.push_instruction(sx_slti(3_s, 1_x, 10));              //     s3 = x1 < 10
+    instruction_mem.push_instruction(split(3_s, 3));                      //     split s3, inner_join
+    instruction_mem.push_instruction(addi(5_x, 5_x, 10));                 //         x5 = x5 + 10
+    instruction_mem.push_instruction(sw(7_s, 8_s, 1280).make_scalar());
+    instruction_mem.push_instruction(join());                             //     inner_join: join
+    instruction_mem.push_instruction(else_(3));                           // else: else outer_join
+    instruction_mem.push_instruction(addi(5_x, 0_x, 2));                  //     x5 = 2
+    instruction_mem.push_instruction(sw(7_s, 8_s, 1152).make_scalar());
+    instruction_mem.push_instruction(join());                             // outer_join: join
+    instruction_mem.push_instruction(sw(1_x, 5_x, 512));                  // Every lane is active again
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 2);
+
+    auto done = simulate(top, instruction_mem, data_mem, 10000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 64; i++) {
+        CHECK(data_mem[512 + i] == (i < 10 ? 11 : i < 40 ? 1 : 2));
+    }
+
+    // Warp 0 has no lane on the else path, warp 1 none on the inner path
+    CHECK(data_mem[1024] == 1);
+    CHECK(data_mem[1024 + 32] == 1);
+    CHECK(data_mem[1280] == 1);
+    CHECK(data_mem[1280 + 32] == 0);
+    CHECK(data_mem[1152] == 0);
+    CHECK(data_mem[1152 + 32] == 1);
+}
+
+TEST_CASE("Vector instructions without active lanes are skipped") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    instruction_mem.push_instruction(addi(5_x, 0_x, 7));
+    instruction_mem.push_instruction(sx_slti(1_s, 1_x, 32));              // No lane of warp 1 stays active
+    instruction_mem.push_instruction(addi(5_x, 0_x, 9));
+    instruction_mem.push_instruction(sw(1_x, 5_x, 512));
+    instruction_mem.push_instruction(lw(6_x, 1_x, 512));
+    instruction_mem.push_instruction(addi(1_s, 0_s, 0xfff).make_scalar()); // All lanes active again
+    instruction_mem.push_instruction(sw(1_x, 5_x, 1024));
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 2);
+
+    auto done = simulate(top, instruction_mem, data_mem, 10000);
+    REQUIRE(done);
+
+    for (auto i = 0u; i < 64; i++) {
+        CHECK(data_mem[512 + i] == (i < 32 ? 9 : 0));
+        CHECK(data_mem[1024 + i] == (i < 32 ? 9 : 7));
+    }
+
+    // The addi, sw and lw of warp 1
+    CHECK(top.perf_zero_mask_skips == 3);
+}
+
+TEST_CASE("Multiply and divide") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    instruction_mem.push_instruction(addi(5_x, 1_x, 0xff0));               // x5 = thread id - 16
+    instruction_mem.push_instruction(addi(6_x, 0_x, 7));
+    instruction_mem.push_instruction(slli(9_x, 1_x, 20));
+    instruction_mem.push_instruction(mul(7_x, 5_x, 6_x));
+    instruction_mem.push_instruction(mulh(8_x, 9_x, 9_x));
+    instruction_mem.push_instruction(div(10_x, 5_x, 6_x));
+    instruction_mem.push_instruction(rem(11_x, 5_x, 6_x));
+    instruction_mem.push_instruction(div(12_x, 5_x, 0_x));
+    instruction_mem.push_instruction(rem(13_x, 5_x, 0_x));
+    instruction_mem.push_instruction(sw(1_x, 7_x, 512));
+    instruction_mem.push_instruction(sw(1_x, 8_x, 544));
+    instruction_mem.push_instruction(sw(1_x, 10_x, 576));
+    instruction_mem.push_instruction(sw(1_x, 11_x, 608));
+    instruction_mem.push_instruction(sw(1_x, 12_x, 640));
+    instruction_mem.push_instruction(sw(1_x, 13_x, 672));
+
+    instruction_mem.push_instruction(addi(5_s, 0_s, 100).make_scalar());
+    instruction_mem.push_instruction(addi(6_s, 0_s, 0xff9).make_scalar());  // s6 = -7
+    instruction_mem.push_instruction(mul(7_s, 5_s, 6_s).make_scalar());
+    instruction_mem.push_instruction(div(8_s, 5_s, 6_s).make_scalar());
+    instruction_mem.push_instruction(rem(9_s, 5_s, 6_s).make_scalar());
+    instruction_mem.push_instruction(sw(0_s, 7_s, 1024).make_scalar());
+    instruction_mem.push_instruction(sw(0_s, 8_s, 1025).make_scalar());
+    instruction_mem.push_instruction(sw(0_s, 9_s, 1026).make_scalar());
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 1);
+
+    auto done = simulate(top, instruction_mem, data_mem, 10000);
+    REQUIRE(done);
+
+    for (auto i = 0; i < 32; i++) {
+        const auto x = i - 16;
+        CHECK(data_mem[512 + i] == static_cast<IData>(x * 7));
+        CHECK(data_mem[544 + i] == static_cast<IData>(i * i) << 8);
+        CHECK(data_mem[576 + i] == static_cast<IData>(x / 7));
+        CHECK(data_mem[608 + i] == static_cast<IData>(x % 7));
+        CHECK(data_mem[640 + i] == 0xffffffff);                 // Division by zero
+        CHECK(data_mem[672 + i] == static_cast<IData>(x));
+    }
+
+    CHECK(data_mem[1024] == static_cast<IData>(-700));
+    CHECK(data_mem[1025] == static_cast<IData>(-14));
+    CHECK(data_mem[1026] == 2);
+}
+
+TEST_CASE("Multiply-accumulate and dot products") {
+    auto top = Vgpu{};
+
+    auto data_mem = sim::make_data_memory<DATA_NUM_CHANNELS>(&top);
+    auto instruction_mem = sim::make_instruction_memory<INST_NUM_CHANNELS>(&top);
+
+    instruction_mem.push_instruction(addi(5_x, 1_x, 0xff0));               // x5 = thread id - 16
+    instruction_mem.push_instruction(addi(6_x, 0_x, 3));
+    instruction_mem.push_instruction(addi(7_x, 0_x, 100));
+    instruction_mem.push_instruction(mac(7_x, 5_x, 6_x));
+    instruction_mem.push_instruction(mac(7_x, 5_x, 6_x));
+    // x8 = bytes {thread id - 16, thread id, 5, 0}, x9 = bytes {3, -1, -1, -1}
+    instruction_mem.push_instruction(andi(8_x, 5_x, 0xff));
+    instruction_mem.push_instruction(slli(10_x, 1_x, 8));
+    instruction_mem.push_instruction(add(8_x, 8_x, 10_x));
+    instruction_mem.push_instruction(lui(10_x, 0x50));
+    instruction_mem.push_instruction(add(8_x, 8_x, 10_x));
+    instruction_mem.push_instruction(addi(9_x, 0_x, 0xf03));
+    instruction_mem.push_instruction(addi(11_x, 0_x, 10));
+    instruction_mem.push_instruction(dot4(11_x, 8_x, 9_x));
+    instruction_mem.push_instruction(sw(1_x, 7_x, 512));
+    instruction_mem.push_instruction(sw(1_x, 11_x, 544));
+
+    instruction_mem.push_instruction(addi(5_s, 0_s, 7).make_scalar());
+    instruction_mem.push_instruction(addi(6_s, 0_s, 0xffd).make_scalar());  // s6 = -3
+    instruction_mem.push_instruction(addi(7_s, 0_s, 50).make_scalar());
+    instruction_mem.push_instruction(mac(7_s, 5_s, 6_s).make_scalar());
+    instruction_mem.push_instruction(addi(9_s, 0_s, 0xf03).make_scalar());
+    instruction_mem.push_instruction(addi(10_s, 0_s, 0x204).make_scalar()); // s10 = bytes {4, 2, 0, 0}
+    instruction_mem.push_instruction(dot4(8_s, 10_s, 9_s).make_scalar());
+    instruction_mem.push_instruction(sw(0_s, 7_s, 1024).make_scalar());
+    instruction_mem.push_instruction(sw(0_s, 8_s, 1025).make_scalar());
+    instruction_mem.push_instruction(halt());
+
+    sim::set_kernel_config(top, 0, 0, 1, 1);
+
+    auto done = simulate(top, instruction_mem, data_mem, 10000);
+    REQUIRE(done);
+
+    for (auto i = 0; i < 32; i++) {
+        CHECK(data_mem[512 + i] == static_cast<IData>(100 + 2 * 3 * (i - 16)));
+        CHECK(data_mem[544 + i] == static_cast<IData>(10 + 3 * (i - 16) - i - 5));
+    }
+
+    CHECK(data_mem[1024] == 29);
+    CHECK(data_mem[1025] == 10);
+}